@@ -3,6 +3,7 @@
 
 //#define DILITHIUM_MODE 2
 #define DILITHIUM_RANDOMIZED_SIGNING
+//#define DILITHIUM_TREE_MU
 //#define USE_RDPMC
 //#define DBENCH
 
@@ -10,6 +11,21 @@
 #define DILITHIUM_MODE 2
 #endif
 
+/* IOSHA stream XOF layout. 2: pad once after the seed/nonce and squeeze
+   full-rate blocks (96 B for stream128, 64 B for stream256). 1: legacy
+   32-byte blocks, each re-padded and permuted. Keys and signatures are not
+   compatible across versions, and under either version keys differ from
+   earlier releases, whose keygen hashed uninitialised stack into the seeds. */
+#ifndef IOSHA_XOF_VERSION
+#define IOSHA_XOF_VERSION 2
+#endif
+
+/* DILITHIUM_TREE_MU: mu absorbs the iosha_tree_bytes root of the message
+   instead of the message itself, so that huge messages are hashed on all
+   cores (make OPENMP=1). Only the one-shot API is parallel: streaming mu
+   (crypto_sign_update, crypto_sign_verify_update) hashes the leaves on a
+   single core. Signer and verifier must agree on it. */
+
 #if DILITHIUM_MODE == 2
 #define CRYPTO_ALGNAME "Dilithium2"
 #define DILITHIUM_NAMESPACETOP pqcrystals_dilithium2_ref
@@ -0,0 +1,327 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "fips202.h"
+#include "fips202x4.h"
+
+#define NROUNDS 24
+
+/* The AVX2 permutation is compiled with a target attribute and picked at
+   run time, so the default build flags stay portable. */
+#if !defined(FIPS202_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(_M_X64))
+#define FIPS202X4_AVX2
+#include <immintrin.h>
+#define FIPS202_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static uint64_t load64(const uint8_t x[8]) {
+  unsigned int i;
+  uint64_t r = 0;
+
+  for(i=0;i<8;i++)
+    r |= (uint64_t)x[i] << 8*i;
+
+  return r;
+}
+
+static void store64(uint8_t x[8], uint64_t u) {
+  unsigned int i;
+
+  for(i=0;i<8;i++)
+    x[i] = u >> 8*i;
+}
+
+/*************************************************
+* Name:        KeccakF1600_StatePermute4x_ref
+*
+* Description: Four Keccak-F1600 permutations, one state at a time.
+*
+* Arguments:   - uint64_t *s: pointer to four lane-interleaved states
+**************************************************/
+static void KeccakF1600_StatePermute4x_ref(uint64_t s[100])
+{
+  unsigned int i, j;
+  uint64_t t[25];
+
+  for(j=0;j<4;j++) {
+    for(i=0;i<25;i++)
+      t[i] = s[4*i+j];
+    KeccakF1600_StatePermute(t);
+    for(i=0;i<25;i++)
+      s[4*i+j] = t[i];
+  }
+}
+
+#ifdef FIPS202X4_AVX2
+#define ROL256(a, offset) _mm256_or_si256(_mm256_slli_epi64(a, offset), \
+                                          _mm256_srli_epi64(a, 64-(offset)))
+
+/* Lane (x,y) is A[x + 5*y]; rho offsets in the same order */
+#define THETA_RHO_PI(x, y, r) \
+  B[(y) + 5*((2*(x) + 3*(y)) % 5)] = \
+    ROL256(_mm256_xor_si256(A[(x) + 5*(y)], D[x]), r)
+
+#define CHI(y) do {                                                         \
+    A[5*(y)+0] = _mm256_xor_si256(B[5*(y)+0],                               \
+                   _mm256_andnot_si256(B[5*(y)+1], B[5*(y)+2]));            \
+    A[5*(y)+1] = _mm256_xor_si256(B[5*(y)+1],                               \
+                   _mm256_andnot_si256(B[5*(y)+2], B[5*(y)+3]));            \
+    A[5*(y)+2] = _mm256_xor_si256(B[5*(y)+2],                               \
+                   _mm256_andnot_si256(B[5*(y)+3], B[5*(y)+4]));            \
+    A[5*(y)+3] = _mm256_xor_si256(B[5*(y)+3],                               \
+                   _mm256_andnot_si256(B[5*(y)+4], B[5*(y)+0]));            \
+    A[5*(y)+4] = _mm256_xor_si256(B[5*(y)+4],                               \
+                   _mm256_andnot_si256(B[5*(y)+0], B[5*(y)+1]));            \
+  } while(0)
+
+/*************************************************
+* Name:        KeccakF1600_StatePermute4x_avx2
+*
+* Description: Four Keccak-F1600 permutations in parallel; vector i holds
+*              lane i of every state.
+*
+* Arguments:   - uint64_t *s: pointer to four lane-interleaved states
+**************************************************/
+FIPS202_TARGET_AVX2
+static void KeccakF1600_StatePermute4x_avx2(uint64_t s[100])
+{
+  unsigned int i, round;
+  __m256i A[25], B[25], C[5], D[5];
+
+  for(i=0;i<25;i++)
+    A[i] = _mm256_loadu_si256((const __m256i *)&s[4*i]);
+
+  for(round = 0; round < NROUNDS; ++round) {
+    for(i=0;i<5;i++)
+      C[i] = _mm256_xor_si256(_mm256_xor_si256(A[i], A[i+5]),
+               _mm256_xor_si256(_mm256_xor_si256(A[i+10], A[i+15]), A[i+20]));
+    for(i=0;i<5;i++)
+      D[i] = _mm256_xor_si256(C[(i+4)%5], ROL256(C[(i+1)%5], 1));
+
+    THETA_RHO_PI(0, 0,  0);
+    THETA_RHO_PI(1, 0,  1);
+    THETA_RHO_PI(2, 0, 62);
+    THETA_RHO_PI(3, 0, 28);
+    THETA_RHO_PI(4, 0, 27);
+    THETA_RHO_PI(0, 1, 36);
+    THETA_RHO_PI(1, 1, 44);
+    THETA_RHO_PI(2, 1,  6);
+    THETA_RHO_PI(3, 1, 55);
+    THETA_RHO_PI(4, 1, 20);
+    THETA_RHO_PI(0, 2,  3);
+    THETA_RHO_PI(1, 2, 10);
+    THETA_RHO_PI(2, 2, 43);
+    THETA_RHO_PI(3, 2, 25);
+    THETA_RHO_PI(4, 2, 39);
+    THETA_RHO_PI(0, 3, 41);
+    THETA_RHO_PI(1, 3, 45);
+    THETA_RHO_PI(2, 3, 15);
+    THETA_RHO_PI(3, 3, 21);
+    THETA_RHO_PI(4, 3,  8);
+    THETA_RHO_PI(0, 4, 18);
+    THETA_RHO_PI(1, 4,  2);
+    THETA_RHO_PI(2, 4, 61);
+    THETA_RHO_PI(3, 4, 56);
+    THETA_RHO_PI(4, 4, 14);
+
+    CHI(0);
+    CHI(1);
+    CHI(2);
+    CHI(3);
+    CHI(4);
+
+    A[0] = _mm256_xor_si256(A[0],
+             _mm256_set1_epi64x((long long)KeccakF_RoundConstants[round]));
+  }
+
+  for(i=0;i<25;i++)
+    _mm256_storeu_si256((__m256i *)&s[4*i], A[i]);
+}
+#endif
+
+/*************************************************
+* Name:        KeccakF1600_StatePermute4x
+*
+* Description: Four independent Keccak-F1600 permutations; AVX2 when the
+*              CPU has it.
+*
+* Arguments:   - uint64_t *s: pointer to four lane-interleaved states
+**************************************************/
+void KeccakF1600_StatePermute4x(uint64_t s[100])
+{
+#ifdef FIPS202X4_AVX2
+  if(__builtin_cpu_supports("avx2")) {
+    KeccakF1600_StatePermute4x_avx2(s);
+    return;
+  }
+#endif
+  KeccakF1600_StatePermute4x_ref(s);
+}
+
+/*************************************************
+* Name:        keccakx4_absorb_once
+*
+* Description: Absorb step of four Keccak states; non-incremental, starts
+*              by zeroeing the states. All inputs have the same length.
+*
+* Arguments:   - uint64_t *s: pointer to (uninitialized) output states
+*              - unsigned int r: rate in bytes (e.g., 168 for SHAKE128)
+*              - const uint8_t *in0, ..., *in3: pointers to inputs
+*              - size_t inlen: length of each input in bytes
+*              - uint8_t p: domain-separation byte
+**************************************************/
+static void keccakx4_absorb_once(uint64_t s[100],
+                                 unsigned int r,
+                                 const uint8_t *in0,
+                                 const uint8_t *in1,
+                                 const uint8_t *in2,
+                                 const uint8_t *in3,
+                                 size_t inlen,
+                                 uint8_t p)
+{
+  unsigned int i, j;
+  const uint8_t *in[4];
+
+  in[0] = in0;
+  in[1] = in1;
+  in[2] = in2;
+  in[3] = in3;
+
+  for(i=0;i<100;i++)
+    s[i] = 0;
+
+  while(inlen >= r) {
+    for(j=0;j<4;j++) {
+      for(i=0;i<r/8;i++)
+        s[4*i+j] ^= load64(in[j]+8*i);
+      in[j] += r;
+    }
+    inlen -= r;
+    KeccakF1600_StatePermute4x(s);
+  }
+
+  for(j=0;j<4;j++) {
+    for(i=0;i<inlen;i++)
+      s[4*(i/8)+j] ^= (uint64_t)in[j][i] << 8*(i%8);
+    s[4*(i/8)+j] ^= (uint64_t)p << 8*(i%8);
+    s[4*((r-1)/8)+j] ^= 1ULL << 63;
+  }
+}
+
+/*************************************************
+* Name:        keccakx4_squeezeblocks
+*
+* Description: Squeeze step of four Keccak states. Squeezes full blocks of
+*              r bytes each into every output.
+*
+* Arguments:   - uint8_t *out0, ..., *out3: pointers to output blocks
+*              - size_t nblocks: number of blocks per output
+*              - uint64_t *s: pointer to input/output states
+*              - unsigned int r: rate in bytes (e.g., 168 for SHAKE128)
+**************************************************/
+static void keccakx4_squeezeblocks(uint8_t *out0,
+                                   uint8_t *out1,
+                                   uint8_t *out2,
+                                   uint8_t *out3,
+                                   size_t nblocks,
+                                   uint64_t s[100],
+                                   unsigned int r)
+{
+  unsigned int i;
+
+  while(nblocks) {
+    KeccakF1600_StatePermute4x(s);
+    for(i=0;i<r/8;i++) {
+      store64(out0+8*i, s[4*i+0]);
+      store64(out1+8*i, s[4*i+1]);
+      store64(out2+8*i, s[4*i+2]);
+      store64(out3+8*i, s[4*i+3]);
+    }
+    out0 += r;
+    out1 += r;
+    out2 += r;
+    out3 += r;
+    nblocks -= 1;
+  }
+}
+
+/*************************************************
+* Name:        shake128x4_absorb_once
+*
+* Description: Initialize, absorb into and finalize four SHAKE128 XOFs;
+*              non-incremental.
+*
+* Arguments:   - keccakx4_state *state: pointer to (uninitialized) states
+*              - const uint8_t *in0, ..., *in3: pointers to inputs
+*              - size_t inlen: length of each input in bytes
+**************************************************/
+void shake128x4_absorb_once(keccakx4_state *state,
+                            const uint8_t *in0,
+                            const uint8_t *in1,
+                            const uint8_t *in2,
+                            const uint8_t *in3,
+                            size_t inlen)
+{
+  keccakx4_absorb_once(state->s, SHAKE128_RATE, in0, in1, in2, in3, inlen, 0x1F);
+}
+
+/*************************************************
+* Name:        shake128x4_squeezeblocks
+*
+* Description: Squeeze step of four SHAKE128 XOFs. Squeezes full blocks
+*              of SHAKE128_RATE bytes each into every output; each
+*              stream equals shake128_squeezeblocks on its own input.
+*
+* Arguments:   - uint8_t *out0, ..., *out3: pointers to output blocks
+*              - size_t nblocks: number of blocks per output
+*              - keccakx4_state *state: pointer to input/output states
+**************************************************/
+void shake128x4_squeezeblocks(uint8_t *out0,
+                              uint8_t *out1,
+                              uint8_t *out2,
+                              uint8_t *out3,
+                              size_t nblocks,
+                              keccakx4_state *state)
+{
+  keccakx4_squeezeblocks(out0, out1, out2, out3, nblocks, state->s, SHAKE128_RATE);
+}
+
+/*************************************************
+* Name:        shake256x4_absorb_once
+*
+* Description: Initialize, absorb into and finalize four SHAKE256 XOFs;
+*              non-incremental.
+*
+* Arguments:   - keccakx4_state *state: pointer to (uninitialized) states
+*              - const uint8_t *in0, ..., *in3: pointers to inputs
+*              - size_t inlen: length of each input in bytes
+**************************************************/
+void shake256x4_absorb_once(keccakx4_state *state,
+                            const uint8_t *in0,
+                            const uint8_t *in1,
+                            const uint8_t *in2,
+                            const uint8_t *in3,
+                            size_t inlen)
+{
+  keccakx4_absorb_once(state->s, SHAKE256_RATE, in0, in1, in2, in3, inlen, 0x1F);
+}
+
+/*************************************************
+* Name:        shake256x4_squeezeblocks
+*
+* Description: Squeeze step of four SHAKE256 XOFs. Squeezes full blocks
+*              of SHAKE256_RATE bytes each into every output.
+*
+* Arguments:   - uint8_t *out0, ..., *out3: pointers to output blocks
+*              - size_t nblocks: number of blocks per output
+*              - keccakx4_state *state: pointer to input/output states
+**************************************************/
+void shake256x4_squeezeblocks(uint8_t *out0,
+                              uint8_t *out1,
+                              uint8_t *out2,
+                              uint8_t *out3,
+                              size_t nblocks,
+                              keccakx4_state *state)
+{
+  keccakx4_squeezeblocks(out0, out1, out2, out3, nblocks, state->s, SHAKE256_RATE);
+}
@@ -11,25 +11,63 @@
 #define RATE_BYTES 64  /* 8 lanes × 8 bytes */
 #define CAPA_BYTES 64  /* 8 lanes × 8 bytes */
 
-static inline uint64_t splitmix64_next(uint64_t *x) {
-    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
-    z ^= z >> 30; z *= 0xBF58476D1CE4E5B9ULL;
-    z ^= z >> 27; z *= 0x94D049BB133111EBULL
-    z ^= z >> 31;
-    return z;
-}
-
-/* Fixed, public round constants (generated once via SplitMix64). */
-static uint64_t RC[IOSHA_ROUNDS][8];
-static int RC_READY = 0;
-static void iosha_rc_init(void) {
-    if (RC_READY) return;
-    uint64_t seed = 0x494F5348415F5652ULL ^ 0xC001D00D5EEDULL; /* "IOSHA_VR" ^ salt */
-    for (int r = 0; r < IOSHA_ROUNDS; ++r)
-        for (int i = 0; i < 8; ++i)
-            RC[r][i] = splitmix64_next(&seed);
-    RC_READY = 1;
-}
+/* x86-64 SIMD engines are compiled with per-function target attributes and
+   picked at run time, so the default build flags stay portable. */
+#if !defined(IOSHA_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(_M_X64))
+#define IOSHA_X86_SIMD
+#include <immintrin.h>
+#define IOSHA_TARGET_AVX2 __attribute__((target("avx2")))
+#define IOSHA_TARGET_AVX512 __attribute__((target("avx512f")))
+#define IOSHA_TARGET_AVX512VL __attribute__((target("avx2,avx512f,avx512vl")))
+static inline int iosha_cpu_avx2(void) { return __builtin_cpu_supports("avx2"); }
+static inline int iosha_cpu_avx512(void) { return __builtin_cpu_supports("avx512f"); }
+static inline int iosha_cpu_avx512vl(void) { return __builtin_cpu_supports("avx512vl"); }
+#endif
+
+/* Fixed, public round constants: successive SplitMix64 outputs seeded with
+   "IOSHA_VR" ^ 0xC001D00D5EED, row by row. Precomputed like the NTT zetas,
+   so the permutation needs no lazy (racy) init; the permutation known-answer
+   test in test/test_iosha covers them. Rows beyond IOSHA_ROUNDS are unused. */
+#define IOSHA_MAX_ROUNDS 16
+#if IOSHA_ROUNDS > IOSHA_MAX_ROUNDS
+#error "IOSHA_ROUNDS exceeds the precomputed round-constant table"
+#endif
+
+static const uint64_t RC[IOSHA_MAX_ROUNDS][8] = {
+    { 0x2CEDB505DD9E575EULL, 0x25CBD749E0BD6766ULL, 0x3F74B1EAB302A5C3ULL, 0xCD2B0114959EF252ULL,
+      0x6441B78EEA726643ULL, 0x958A560138DC613EULL, 0xBE523FCBDB29B547ULL, 0x02E6729A6D9EC339ULL },
+    { 0x552A73D7D21B0FECULL, 0x6A902BB782CBBEC9ULL, 0x3ED6D57BD469E376ULL, 0x2D6A779AF4E0A751ULL,
+      0x29CF5DBE899C2ECBULL, 0x1BDC003F39F8D9ECULL, 0x68E25536F4510C01ULL, 0xA89EE6E1BE745C0AULL },
+    { 0x8F3CD74EE17F23CAULL, 0x8A72D2F9DCFE371BULL, 0x0DF8A965709CA525ULL, 0x8A32B2FED86972B7ULL,
+      0x8B4A0232CF86F624ULL, 0xC09EB630D57E18F4ULL, 0x311932EA04B7D8ECULL, 0x6CF2430A4AC822AEULL },
+    { 0x3520FD2D98DF1D9FULL, 0x44F42948321AFC6FULL, 0x0F175891CFEECC1DULL, 0xB40CEEB84024C988ULL,
+      0x7D8951A5DA82A517ULL, 0xF776CA872E595E3EULL, 0xF970A9FA728402C3ULL, 0x376A13BD96F5B765ULL },
+    { 0x0751C3F421754F76ULL, 0x10B77C98A7B4E5F8ULL, 0xD08FD988403A7E16ULL, 0x9B83762C572B8C24ULL,
+      0xE1096ADEB01A010CULL, 0xA1561C81917BD1B4ULL, 0x81E217B1642F3974ULL, 0x28D10FF566608B9AULL },
+    { 0x5C0EE59AF8639171ULL, 0x2B7A3BF631F17175ULL, 0x91918E7A617147FAULL, 0x31641A6EF4168B65ULL,
+      0xD2CF07A51AF151EDULL, 0xB5EC532DCD42D289ULL, 0x969CC755CCAAAEEBULL, 0xC60F54F84C364FAAULL },
+    { 0x165E87472A4B36BCULL, 0x511D9A40E974C62BULL, 0x7B656EBFD93E7B70ULL, 0x3D7C8D96DBBBF547ULL,
+      0x4E837B803E4E4A0DULL, 0x8F2943CAB1B238EEULL, 0x6576E527C513361CULL, 0x41FA912A38D2191CULL },
+    { 0x1C3DC16CB89B7882ULL, 0xAA652E87DAA84D80ULL, 0x9DB878811C09F27CULL, 0x9A9EFEBC55DA88DFULL,
+      0x51DE21310C7B90BFULL, 0x1102718CC59DC45DULL, 0xF1C70DD8A2E548A9ULL, 0x73EA9EE35A5F2A29ULL },
+    { 0x6F409E43E80C7FADULL, 0xC32D545AA5971B67ULL, 0x21B0A386B01077ADULL, 0xAEDEF97CEEEAB64FULL,
+      0x6CA68AED6566704EULL, 0x1C6C455FD19F9D6CULL, 0x98EDAC4BDC4FD436ULL, 0x015756F0A2E78670ULL },
+    { 0xD85A2F02E94FCAE6ULL, 0x96EC7F0365E5F3F6ULL, 0xEA7C66FFB5D4E979ULL, 0x4B7B3B54EC9BA309ULL,
+      0xC88AF73169EFB5D7ULL, 0x9A92287FA6CF4E28ULL, 0xA25C24A9CAC0A411ULL, 0xB2FD9EB49EDFB120ULL },
+    { 0xA318D3F5131EA975ULL, 0x831FCB415111D44BULL, 0xCC469211DBCA69EAULL, 0x8DE0D096C808B7DAULL,
+      0x2AFFB221F08E3D11ULL, 0x82FD8086EDC168E3ULL, 0x8FBDB03D2788B54CULL, 0xBE8628CEF7A94FFCULL },
+    { 0x04E96E442AC3FE68ULL, 0x9D88C288B39B64C8ULL, 0x26F3DD28B570369EULL, 0x2F0A5F313C30DD33ULL,
+      0x4C06927121C6443BULL, 0x3F7A7A5E56558A3CULL, 0x0CBA63385C053472ULL, 0xA5B7D860C3283E0DULL },
+    { 0x496FFF3368921796ULL, 0x35EC3B27DB5E84B4ULL, 0x6E6D7090056D7E6FULL, 0x056C305925A37BA1ULL,
+      0xC5851572EC37D6F9ULL, 0x8D259A7F64BD6D85ULL, 0x11A414AC0FE393F3ULL, 0x81C56B7B2E24C570ULL },
+    { 0x3CE63452C43713CEULL, 0xAAFC33A997126670ULL, 0x6C5B8EF4A2F54328ULL, 0x38DF10B2D8B88A72ULL,
+      0xC5B3297F2B7533C5ULL, 0x841437B89C7CA475ULL, 0xDAEDB32D42F51603ULL, 0xF49FCEA33A84030EULL },
+    { 0xAD4CF56058F86A89ULL, 0xAC90612502956FC1ULL, 0xC82F0A0B87B4EED8ULL, 0xB0DD36E3B8A9DA46ULL,
+      0x4A75374AFA7D64FEULL, 0x7D151982BA3ED525ULL, 0xEDECB39766635902ULL, 0xB2E30C40D3281A9CULL },
+    { 0x8C04D7539AD69E54ULL, 0xCF753BA0C5D3725AULL, 0x6955CB867149F62FULL, 0x346138D925652724ULL,
+      0xCEC04C1A13D5FFDDULL, 0xF229EC628B35ABA4ULL, 0xC019B7D76803424AULL, 0x4CC1BE4D932B9B43ULL }
+};
 
 // /* Lane rotation schedules (odd, distinct; chosen for diffusion) */
 // static const unsigned ROT_A[8] = {23, 59,  7,  3, 13, 43, 29, 19};
@@ -60,30 +98,134 @@ static inline void arxbox8(uint64_t x[8], const uint64_t rc[8]) {
         x[i] ^= ROTL64(t, ROT_G[i]);
 }
 
-/* Full-state permutation: Feistel over (rate=L, capacity=R) halves. */
-static void iosha_permute(uint64_t s[16]) {
-    iosha_rc_init();
+/* Full-state permutation: Feistel over (rate=L, capacity=R) halves.
+   Two rounds per iteration, L ^= F(R) then R ^= F(L), so the halves never
+   trade places; an odd final round has no swap to undo either. Unrolling
+   all rounds with literal RC rows is slower, not faster: the straight-line
+   body no longer keeps the lanes in registers. */
+static void iosha_permute_ref(uint64_t s[16]) {
+    uint64_t L[8], R[8], T[8];
+    int r;
 
-    uint64_t L[8], R[8];
     for (int i = 0; i < 8; ++i) { L[i] = s[i]; R[i] = s[8 + i]; }
 
-    for (int r = 0; r < IOSHA_ROUNDS; ++r) {
-        uint64_t T[8];
-        for (int i = 0; i < 8; ++i) T[i] = R[i];     /* T = R */
-        arxbox8(T, RC[r]);                           /* T = F(R, rc[r]) */
-        for (int i = 0; i < 8; ++i) L[i] ^= T[i];    /* L = L ^ T       */
-        /* swap(L, R) */
-        for (int i = 0; i < 8; ++i) { uint64_t tmp = L[i]; L[i] = R[i]; R[i] = tmp; }
+    for (r = 0; r + 1 < IOSHA_ROUNDS; r += 2) {
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] ^= T[i];
+
+        for (int i = 0; i < 8; ++i) T[i] = L[i];
+        arxbox8(T, RC[r + 1]);
+        for (int i = 0; i < 8; ++i) R[i] ^= T[i];
     }
 
-    /* After N swaps, halves are swapped; restore so rate stays s[0..7]. */
     if (IOSHA_ROUNDS & 1) {
-        for (int i = 0; i < 8; ++i) { uint64_t tmp = L[i]; L[i] = R[i]; R[i] = tmp; }
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] ^= T[i];
     }
 
     for (int i = 0; i < 8; ++i) { s[i] = L[i]; s[8 + i] = R[i]; }
 }
 
+#ifdef IOSHA_X86_SIMD
+/* Single-state SIMD permutation. Rotations need vprolvq/vprorvq on ymm
+   (AVX-512VL); emulating them with shift pairs on plain AVX2 is slower
+   than the scalar code, so such hosts keep iosha_permute_ref. */
+#define ROTLV256(x,r) _mm256_rolv_epi64((x), (r))
+#define ROTRV256(x,r) _mm256_rorv_epi64((x), (r))
+
+/* arxbox8 on one state held as lo = x[0..3], hi = x[4..7]. The neighbour
+   gathers become cross-lane shuffles; hi is built from the already
+   updated lo, which reproduces the in-place wrap-around of the scalar
+   loops (x[7] sees the new x[0], x[6]/x[7] the new x[0]/x[1]). */
+IOSHA_TARGET_AVX512VL
+static inline void arxbox8_ymm(__m256i *lo, __m256i *hi, const uint64_t rc[8]) {
+    const __m256i a_lo = _mm256_setr_epi64x(ROT_A[0], ROT_A[1], ROT_A[2], ROT_A[3]);
+    const __m256i a_hi = _mm256_setr_epi64x(ROT_A[4], ROT_A[5], ROT_A[6], ROT_A[7]);
+    const __m256i b_lo = _mm256_setr_epi64x(ROT_B[0], ROT_B[1], ROT_B[2], ROT_B[3]);
+    const __m256i b_hi = _mm256_setr_epi64x(ROT_B[4], ROT_B[5], ROT_B[6], ROT_B[7]);
+    const __m256i g_lo = _mm256_setr_epi64x(ROT_G[0], ROT_G[1], ROT_G[2], ROT_G[3]);
+    const __m256i g_hi = _mm256_setr_epi64x(ROT_G[4], ROT_G[5], ROT_G[6], ROT_G[7]);
+    __m256i n, t;
+
+    /* Mix 1: neighbours (x1..x4) and (x5,x6,x7,x0') */
+    n   = _mm256_alignr_epi8(_mm256_permute2x128_si256(*lo, *hi, 0x21), *lo, 8);
+    *lo = _mm256_add_epi64(*lo, ROTLV256(n, a_lo));
+    n   = _mm256_alignr_epi8(_mm256_permute2x128_si256(*hi, *lo, 0x21), *hi, 8);
+    *hi = _mm256_add_epi64(*hi, ROTLV256(n, a_hi));
+
+    /* Mix 2: next-neighbours (x2..x5) and (x6,x7,x0',x1') */
+    n   = _mm256_permute2x128_si256(*lo, *hi, 0x21);
+    *lo = _mm256_xor_si256(*lo, ROTRV256(n, b_lo));
+    n   = _mm256_permute2x128_si256(*hi, *lo, 0x21);
+    *hi = _mm256_xor_si256(*hi, ROTRV256(n, b_hi));
+
+    *lo = _mm256_add_epi64(*lo, _mm256_loadu_si256((const __m256i *)&rc[0]));
+    *hi = _mm256_add_epi64(*hi, _mm256_loadu_si256((const __m256i *)&rc[4]));
+
+    /* Parity broadcast to all four lanes */
+    t = _mm256_xor_si256(*lo, *hi);
+    t = _mm256_xor_si256(t, _mm256_permute4x64_epi64(t, 0x4E));
+    t = _mm256_xor_si256(t, _mm256_shuffle_epi32(t, 0x4E));
+    *lo = _mm256_xor_si256(*lo, ROTLV256(t, g_lo));
+    *hi = _mm256_xor_si256(*hi, ROTLV256(t, g_hi));
+}
+
+IOSHA_TARGET_AVX512VL
+static void iosha_permute_ymm(uint64_t s[16]) {
+    __m256i l0, l1, r0, r1, t0, t1;
+    int r;
+
+    l0 = _mm256_loadu_si256((const __m256i *)&s[0]);
+    l1 = _mm256_loadu_si256((const __m256i *)&s[4]);
+    r0 = _mm256_loadu_si256((const __m256i *)&s[8]);
+    r1 = _mm256_loadu_si256((const __m256i *)&s[12]);
+
+    for (r = 0; r + 1 < IOSHA_ROUNDS; r += 2) {
+        t0 = r0; t1 = r1;
+        arxbox8_ymm(&t0, &t1, RC[r]);
+        l0 = _mm256_xor_si256(l0, t0);
+        l1 = _mm256_xor_si256(l1, t1);
+
+        t0 = l0; t1 = l1;
+        arxbox8_ymm(&t0, &t1, RC[r + 1]);
+        r0 = _mm256_xor_si256(r0, t0);
+        r1 = _mm256_xor_si256(r1, t1);
+    }
+
+    if (IOSHA_ROUNDS & 1) {
+        t0 = r0; t1 = r1;
+        arxbox8_ymm(&t0, &t1, RC[r]);
+        l0 = _mm256_xor_si256(l0, t0);
+        l1 = _mm256_xor_si256(l1, t1);
+    }
+
+    _mm256_storeu_si256((__m256i *)&s[0], l0);
+    _mm256_storeu_si256((__m256i *)&s[4], l1);
+    _mm256_storeu_si256((__m256i *)&s[8], r0);
+    _mm256_storeu_si256((__m256i *)&s[12], r1);
+}
+#endif
+
+#ifdef IOSHA_STATS
+unsigned long long iosha_permute_count = 0;
+#define IOSHA_COUNT(n) (iosha_permute_count += (n))
+#else
+#define IOSHA_COUNT(n) ((void)0)
+#endif
+
+void iosha_permute(uint64_t s[16]) {
+    IOSHA_COUNT(1);
+#ifdef IOSHA_X86_SIMD
+    if (iosha_cpu_avx512vl()) {
+        iosha_permute_ymm(s);
+        return;
+    }
+#endif
+    iosha_permute_ref(s);
+}
+
 /* ===================== Sponge core (pad10*1) ===================== */
 
 static inline void iosha_pad10star1_and_permute(iosha_ctx *ctx) {
@@ -96,6 +238,18 @@ static inline void iosha_pad10star1_and_permute(iosha_ctx *ctx) {
 
 /* ===================== Public API impl ===================== */
 
+/* Native-endian word load/store: XORing or copying a whole lane this way
+   is the same as doing it byte by byte through (uint8_t *)st. */
+static inline uint64_t load64_ne(const uint8_t *x) {
+    uint64_t r;
+    memcpy(&r, x, 8);
+    return r;
+}
+
+static inline void store64_ne(uint8_t *x, uint64_t v) {
+    memcpy(x, &v, 8);
+}
+
 static inline void zero_state(uint64_t st[16]) { memset(st, 0, 16*sizeof(uint64_t)); }
 
 static void iosha_init_common(iosha_ctx *ctx, uint8_t tag, uint32_t rate_bytes) {
@@ -121,15 +275,23 @@ void iosha_init_128(iosha_ctx *ctx, uint8_t tag) {
     iosha_init_common(ctx, tag, 96);
 }
 
-/* XOR-absorb into the first 64 bytes (the rate). Permute on full blocks. */
+/* XOR-absorb into the rate. Bytes are only handled one at a time up to the
+   next lane boundary and for a short tail; whole lanes are XORed as 64-bit
+   words, so full-rate blocks are rate/8 word XORs (vectorised by the
+   compiler) followed by the permutation. */
 void iosha_absorb(iosha_ctx *ctx, const uint8_t *in, size_t inlen)
 {
     uint8_t *b = (uint8_t*)ctx->st;
     while (inlen) {
         size_t room = ctx->rate - ctx->idx;
+        size_t i = 0;
         if (room > inlen) room = inlen;
 
-        for (size_t i = 0; i < room; ++i)
+        for (; i < room && ((ctx->idx + i) & 7); ++i)
+            b[ctx->idx + i] ^= in[i];
+        for (; i + 8 <= room; i += 8)
+            ctx->st[(ctx->idx + i) >> 3] ^= load64_ne(in + i);
+        for (; i < room; ++i)
             b[ctx->idx + i] ^= in[i];
 
         ctx->idx += room;
@@ -169,6 +331,35 @@ void iosha_squeeze_128(iosha_ctx *ctx, uint8_t *out, size_t outlen)
     iosha_squeeze(ctx, out, outlen);
 }
 
+/* Fork a sponge: dst continues independently from src's current state,
+   e.g. from a precomputed prefix that is shared by many messages. */
+void iosha_clone(iosha_ctx *dst, const iosha_ctx *src)
+{
+    memcpy(dst, src, sizeof(*dst));
+}
+
+/* Finalize once, squeeze many: pad10*1 is applied a single time and every
+   iosha_squeezeblocks block is one permutation yielding a full rate. The
+   first block equals the first iosha_squeeze output; later ones differ
+   because iosha_squeeze re-pads on every call. */
+void iosha_finalize(iosha_ctx *ctx)
+{
+    uint8_t *b = (uint8_t*)ctx->st;
+    b[ctx->idx]      ^= 0x01;
+    b[ctx->rate - 1] ^= 0x80;
+    ctx->idx = ctx->rate;             /* rate exhausted: permute before output */
+}
+
+void iosha_squeezeblocks(uint8_t *out, size_t nblocks, iosha_ctx *ctx)
+{
+    while (nblocks--) {
+        iosha_permute(ctx->st);
+        memcpy(out, ctx->st, ctx->rate);
+        out += ctx->rate;
+    }
+    ctx->idx = ctx->rate;
+}
+
 /* One-shot XOF: tag=0x01, absorb nonce (LE16) || seed, squeeze outlen bytes. */
 void iosha_xof_bytes(const uint8_t *seed, size_t seedlen,
                      uint16_t nonce, uint8_t *out, size_t outlen)
@@ -190,6 +381,569 @@ void iosha_crh_bytes(const uint8_t *in, size_t inlen,
     iosha_squeeze(&ctx, out, outlen);      /* ask for 64 bytes for 256-bit collisions */
 }
 
+/* ===================== 4-way multi-buffer ===================== */
+
+/* Byte p of stream j in a lane-interleaved x4 state. */
+#define X4_BYTE(st, j, p) (((uint8_t *)&(st)[4 * ((p) >> 3) + (j)])[(p) & 7])
+
+static void iosha_permute_x4_ref(uint64_t s[64]) {
+    uint64_t t[16];
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 16; ++i) t[i] = s[4 * i + j];
+        iosha_permute(t);
+        for (int i = 0; i < 16; ++i) s[4 * i + j] = t[i];
+    }
+}
+
+#ifdef IOSHA_X86_SIMD
+#define ROTL256(x,r) _mm256_or_si256(_mm256_slli_epi64((x), (r)), \
+                                     _mm256_srli_epi64((x), 64 - (r)))
+#define ROTR256(x,r) _mm256_or_si256(_mm256_srli_epi64((x), (r)), \
+                                     _mm256_slli_epi64((x), 64 - (r)))
+
+/* arxbox8 on four states at once; vector i holds lane i of every state. */
+IOSHA_TARGET_AVX2
+static inline void arxbox8_x4(__m256i x[8], const uint64_t rc[8]) {
+    __m256i t;
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm256_add_epi64(x[i], ROTL256(x[(i + 1) & 7], ROT_A[i]));
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm256_xor_si256(x[i], ROTR256(x[(i + 2) & 7], ROT_B[i]));
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm256_add_epi64(x[i], _mm256_set1_epi64x((long long)rc[i]));
+
+    t = _mm256_xor_si256(_mm256_xor_si256(x[0], x[1]), _mm256_xor_si256(x[2], x[3]));
+    t = _mm256_xor_si256(t, _mm256_xor_si256(_mm256_xor_si256(x[4], x[5]),
+                                             _mm256_xor_si256(x[6], x[7])));
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm256_xor_si256(x[i], ROTL256(t, ROT_G[i]));
+}
+
+IOSHA_TARGET_AVX2
+static void iosha_permute_x4_avx2(uint64_t s[64]) {
+    __m256i L[8], R[8], T[8];
+    int r;
+
+    for (int i = 0; i < 8; ++i) {
+        L[i] = _mm256_loadu_si256((const __m256i *)&s[4 * i]);
+        R[i] = _mm256_loadu_si256((const __m256i *)&s[4 * (8 + i)]);
+    }
+
+    for (r = 0; r + 1 < IOSHA_ROUNDS; r += 2) {
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8_x4(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] = _mm256_xor_si256(L[i], T[i]);
+
+        for (int i = 0; i < 8; ++i) T[i] = L[i];
+        arxbox8_x4(T, RC[r + 1]);
+        for (int i = 0; i < 8; ++i) R[i] = _mm256_xor_si256(R[i], T[i]);
+    }
+
+    if (IOSHA_ROUNDS & 1) {
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8_x4(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] = _mm256_xor_si256(L[i], T[i]);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        _mm256_storeu_si256((__m256i *)&s[4 * i], L[i]);
+        _mm256_storeu_si256((__m256i *)&s[4 * (8 + i)], R[i]);
+    }
+}
+#endif
+
+/* Four independent permutations; s[4*i + j] is lane i of state j. */
+void iosha_permute_x4(uint64_t s[64]) {
+#ifdef IOSHA_X86_SIMD
+    if (iosha_cpu_avx2()) {
+        IOSHA_COUNT(4);                /* the ref path counts per stream */
+        iosha_permute_x4_avx2(s);
+        return;
+    }
+#endif
+    iosha_permute_x4_ref(s);
+}
+
+static void iosha_init_common_x4(iosha_ctx_x4 *ctx, uint8_t tag, uint32_t rate_bytes) {
+    iosha_ctx one;
+
+    iosha_init_common(&one, tag, rate_bytes);
+    for (int i = 0; i < 16; ++i)
+        for (int j = 0; j < 4; ++j)
+            ctx->st[4 * i + j] = one.st[i];
+    ctx->idx  = 0;
+    ctx->rate = rate_bytes;
+}
+
+void iosha_init_x4(iosha_ctx_x4 *ctx, uint8_t tag) {
+    iosha_init_common_x4(ctx, tag, 64);
+}
+
+void iosha_init_128_x4(iosha_ctx_x4 *ctx, uint8_t tag) {
+    iosha_init_common_x4(ctx, tag, 96);
+}
+
+/* Same-length absorb into all four streams; matches iosha_absorb per stream. */
+void iosha_absorb_x4(iosha_ctx_x4 *ctx,
+                     const uint8_t *in0, const uint8_t *in1,
+                     const uint8_t *in2, const uint8_t *in3, size_t inlen)
+{
+    const uint8_t *in[4] = { in0, in1, in2, in3 };
+    size_t off = 0;
+
+    while (inlen) {
+        size_t room = ctx->rate - ctx->idx;
+        if (room > inlen) room = inlen;
+
+        for (int j = 0; j < 4; ++j) {
+            size_t i = 0;
+            for (; i < room && ((ctx->idx + i) & 7); ++i)
+                X4_BYTE(ctx->st, j, ctx->idx + i) ^= in[j][off + i];
+            for (; i + 8 <= room; i += 8)
+                ctx->st[4 * ((ctx->idx + i) >> 3) + j] ^= load64_ne(in[j] + off + i);
+            for (; i < room; ++i)
+                X4_BYTE(ctx->st, j, ctx->idx + i) ^= in[j][off + i];
+        }
+
+        ctx->idx += room;
+        off     += room;
+        inlen   -= room;
+
+        if (ctx->idx == ctx->rate) {
+            iosha_permute_x4(ctx->st);
+            ctx->idx = 0;
+        }
+    }
+}
+
+/* Same-length squeeze from all four streams; matches iosha_squeeze per stream. */
+void iosha_squeeze_x4(iosha_ctx_x4 *ctx,
+                      uint8_t *out0, uint8_t *out1,
+                      uint8_t *out2, uint8_t *out3, size_t outlen)
+{
+    uint8_t *out[4] = { out0, out1, out2, out3 };
+    size_t off = 0;
+
+    for (int j = 0; j < 4; ++j) {
+        X4_BYTE(ctx->st, j, ctx->idx)      ^= 0x01;
+        X4_BYTE(ctx->st, j, ctx->rate - 1) ^= 0x80;
+    }
+    iosha_permute_x4(ctx->st);
+    ctx->idx = 0;
+
+    while (outlen) {
+        size_t n = (outlen < ctx->rate) ? outlen : ctx->rate;
+        for (int j = 0; j < 4; ++j) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                store64_ne(out[j] + off + i, ctx->st[4 * (i >> 3) + j]);
+            for (; i < n; ++i)
+                out[j][off + i] = X4_BYTE(ctx->st, j, i);
+        }
+        off    += n;
+        outlen -= n;
+        if (outlen) iosha_permute_x4(ctx->st);
+    }
+}
+
+
+void iosha_finalize_x4(iosha_ctx_x4 *ctx)
+{
+    for (int j = 0; j < 4; ++j) {
+        X4_BYTE(ctx->st, j, ctx->idx)      ^= 0x01;
+        X4_BYTE(ctx->st, j, ctx->rate - 1) ^= 0x80;
+    }
+    ctx->idx = ctx->rate;
+}
+
+void iosha_squeezeblocks_x4(uint8_t *out0, uint8_t *out1,
+                            uint8_t *out2, uint8_t *out3,
+                            size_t nblocks, iosha_ctx_x4 *ctx)
+{
+    uint8_t *out[4] = { out0, out1, out2, out3 };
+    size_t off = 0;
+
+    while (nblocks--) {
+        iosha_permute_x4(ctx->st);
+        for (int j = 0; j < 4; ++j)
+            for (size_t i = 0; i < ctx->rate; i += 8)
+                store64_ne(out[j] + off + i, ctx->st[4 * (i >> 3) + j]);
+        off += ctx->rate;
+    }
+    ctx->idx = ctx->rate;
+}
+
+/* ===================== 8-way multi-buffer ===================== */
+
+/* Byte p of stream j in a lane-interleaved x8 state. */
+#define X8_BYTE(st, j, p) (((uint8_t *)&(st)[8 * ((p) >> 3) + (j)])[(p) & 7])
+
+/* Without AVX-512 run the two halves through the x4 engine. */
+static void iosha_permute_x8_ref(uint64_t s[128]) {
+    uint64_t h[64];
+    for (int k = 0; k < 8; k += 4) {
+        for (int i = 0; i < 16; ++i)
+            for (int j = 0; j < 4; ++j) h[4 * i + j] = s[8 * i + k + j];
+        iosha_permute_x4(h);
+        for (int i = 0; i < 16; ++i)
+            for (int j = 0; j < 4; ++j) s[8 * i + k + j] = h[4 * i + j];
+    }
+}
+
+#ifdef IOSHA_X86_SIMD
+/* vprolvq/vprorvq with a splatted count; the all-ones zero-mask form keeps
+   GCC's _mm512_undefined_epi32() passthrough out of the picture. */
+#define ROLV512(x,r) _mm512_maskz_rolv_epi64((__mmask8)0xFF, (x), _mm512_set1_epi64(r))
+#define RORV512(x,r) _mm512_maskz_rorv_epi64((__mmask8)0xFF, (x), _mm512_set1_epi64(r))
+
+/* arxbox8 on eight states; the parity fold uses three-way XOR
+   (vpternlogq 0x96). */
+IOSHA_TARGET_AVX512
+static inline void arxbox8_x8(__m512i x[8], const uint64_t rc[8]) {
+    __m512i t;
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm512_add_epi64(x[i], ROLV512(x[(i + 1) & 7], ROT_A[i]));
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm512_xor_si512(x[i], RORV512(x[(i + 2) & 7], ROT_B[i]));
+
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm512_add_epi64(x[i], _mm512_set1_epi64((long long)rc[i]));
+
+    t = _mm512_ternarylogic_epi64(x[0], x[1], x[2], 0x96);
+    t = _mm512_ternarylogic_epi64(t, x[3], x[4], 0x96);
+    t = _mm512_ternarylogic_epi64(t, x[5], x[6], 0x96);
+    t = _mm512_xor_si512(t, x[7]);
+    for (int i = 0; i < 8; ++i)
+        x[i] = _mm512_xor_si512(x[i], ROLV512(t, ROT_G[i]));
+}
+
+IOSHA_TARGET_AVX512
+static void iosha_permute_x8_avx512(uint64_t s[128]) {
+    __m512i L[8], R[8], T[8];
+    int r;
+
+    for (int i = 0; i < 8; ++i) {
+        L[i] = _mm512_loadu_si512((const void *)&s[8 * i]);
+        R[i] = _mm512_loadu_si512((const void *)&s[8 * (8 + i)]);
+    }
+
+    for (r = 0; r + 1 < IOSHA_ROUNDS; r += 2) {
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8_x8(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] = _mm512_xor_si512(L[i], T[i]);
+
+        for (int i = 0; i < 8; ++i) T[i] = L[i];
+        arxbox8_x8(T, RC[r + 1]);
+        for (int i = 0; i < 8; ++i) R[i] = _mm512_xor_si512(R[i], T[i]);
+    }
+
+    if (IOSHA_ROUNDS & 1) {
+        for (int i = 0; i < 8; ++i) T[i] = R[i];
+        arxbox8_x8(T, RC[r]);
+        for (int i = 0; i < 8; ++i) L[i] = _mm512_xor_si512(L[i], T[i]);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        _mm512_storeu_si512((void *)&s[8 * i], L[i]);
+        _mm512_storeu_si512((void *)&s[8 * (8 + i)], R[i]);
+    }
+}
+#endif
+
+/* 1 when iosha_permute_x8 runs on AVX-512 rather than as two x4 halves */
+int iosha_x8_native(void) {
+#ifdef IOSHA_X86_SIMD
+    return iosha_cpu_avx512();
+#else
+    return 0;
+#endif
+}
+
+/* Eight independent permutations; s[8*i + j] is lane i of state j. */
+void iosha_permute_x8(uint64_t s[128]) {
+#ifdef IOSHA_X86_SIMD
+    if (iosha_x8_native()) {
+        IOSHA_COUNT(8);
+        iosha_permute_x8_avx512(s);
+        return;
+    }
+#endif
+    iosha_permute_x8_ref(s);
+}
+
+static void iosha_init_common_x8(iosha_ctx_x8 *ctx, uint8_t tag, uint32_t rate_bytes) {
+    iosha_ctx one;
+
+    iosha_init_common(&one, tag, rate_bytes);
+    for (int i = 0; i < 16; ++i)
+        for (int j = 0; j < 8; ++j)
+            ctx->st[8 * i + j] = one.st[i];
+    ctx->idx  = 0;
+    ctx->rate = rate_bytes;
+}
+
+void iosha_init_x8(iosha_ctx_x8 *ctx, uint8_t tag) {
+    iosha_init_common_x8(ctx, tag, 64);
+}
+
+void iosha_init_128_x8(iosha_ctx_x8 *ctx, uint8_t tag) {
+    iosha_init_common_x8(ctx, tag, 96);
+}
+
+/* Same-length absorb into all eight streams; matches iosha_absorb per stream. */
+void iosha_absorb_x8(iosha_ctx_x8 *ctx,
+                     const uint8_t *in0, const uint8_t *in1,
+                     const uint8_t *in2, const uint8_t *in3,
+                     const uint8_t *in4, const uint8_t *in5,
+                     const uint8_t *in6, const uint8_t *in7, size_t inlen)
+{
+    const uint8_t *in[8] = { in0, in1, in2, in3, in4, in5, in6, in7 };
+    size_t off = 0;
+
+    while (inlen) {
+        size_t room = ctx->rate - ctx->idx;
+        if (room > inlen) room = inlen;
+
+        for (int j = 0; j < 8; ++j) {
+            size_t i = 0;
+            for (; i < room && ((ctx->idx + i) & 7); ++i)
+                X8_BYTE(ctx->st, j, ctx->idx + i) ^= in[j][off + i];
+            for (; i + 8 <= room; i += 8)
+                ctx->st[8 * ((ctx->idx + i) >> 3) + j] ^= load64_ne(in[j] + off + i);
+            for (; i < room; ++i)
+                X8_BYTE(ctx->st, j, ctx->idx + i) ^= in[j][off + i];
+        }
+
+        ctx->idx += room;
+        off     += room;
+        inlen   -= room;
+
+        if (ctx->idx == ctx->rate) {
+            iosha_permute_x8(ctx->st);
+            ctx->idx = 0;
+        }
+    }
+}
+
+/* Same-length squeeze from all eight streams; matches iosha_squeeze per stream. */
+void iosha_squeeze_x8(iosha_ctx_x8 *ctx,
+                      uint8_t *out0, uint8_t *out1,
+                      uint8_t *out2, uint8_t *out3,
+                      uint8_t *out4, uint8_t *out5,
+                      uint8_t *out6, uint8_t *out7, size_t outlen)
+{
+    uint8_t *out[8] = { out0, out1, out2, out3, out4, out5, out6, out7 };
+    size_t off = 0;
+
+    for (int j = 0; j < 8; ++j) {
+        X8_BYTE(ctx->st, j, ctx->idx)      ^= 0x01;
+        X8_BYTE(ctx->st, j, ctx->rate - 1) ^= 0x80;
+    }
+    iosha_permute_x8(ctx->st);
+    ctx->idx = 0;
+
+    while (outlen) {
+        size_t n = (outlen < ctx->rate) ? outlen : ctx->rate;
+        for (int j = 0; j < 8; ++j) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                store64_ne(out[j] + off + i, ctx->st[8 * (i >> 3) + j]);
+            for (; i < n; ++i)
+                out[j][off + i] = X8_BYTE(ctx->st, j, i);
+        }
+        off    += n;
+        outlen -= n;
+        if (outlen) iosha_permute_x8(ctx->st);
+    }
+}
+
+
+void iosha_finalize_x8(iosha_ctx_x8 *ctx)
+{
+    for (int j = 0; j < 8; ++j) {
+        X8_BYTE(ctx->st, j, ctx->idx)      ^= 0x01;
+        X8_BYTE(ctx->st, j, ctx->rate - 1) ^= 0x80;
+    }
+    ctx->idx = ctx->rate;
+}
+
+void iosha_squeezeblocks_x8(uint8_t *out0, uint8_t *out1,
+                            uint8_t *out2, uint8_t *out3,
+                            uint8_t *out4, uint8_t *out5,
+                            uint8_t *out6, uint8_t *out7,
+                            size_t nblocks, iosha_ctx_x8 *ctx)
+{
+    uint8_t *out[8] = { out0, out1, out2, out3, out4, out5, out6, out7 };
+    size_t off = 0;
+
+    while (nblocks--) {
+        iosha_permute_x8(ctx->st);
+        for (int j = 0; j < 8; ++j)
+            for (size_t i = 0; i < ctx->rate; i += 8)
+                store64_ne(out[j] + off + i, ctx->st[8 * (i >> 3) + j]);
+        off += ctx->rate;
+    }
+    ctx->idx = ctx->rate;
+}
+
+/* ===================== Tree hashing ===================== */
+
+/* Leaves are hashed independently (tag 0x03, leaf index LE64 || chunk)
+   into 64-byte chaining values; the root (tag 0x04) absorbs the chaining
+   values in order followed by the message length LE64. Leaves are
+   processed four at a time with the x4 engine and, when built with
+   OpenMP, spread over all cores one batch at a time. */
+#define IOSHA_TAG_LEAF 0x03
+#define IOSHA_TAG_ROOT 0x04
+#define IOSHA_TREE_CVBYTES 64
+#define IOSHA_TREE_BATCH 256   /* leaves per parallel batch, multiple of 4 */
+
+static void le64(uint8_t b[8], uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) b[i] = (uint8_t)(v >> 8 * i);
+}
+
+static void iosha_tree_leaf(uint8_t cv[IOSHA_TREE_CVBYTES], uint64_t index,
+                            const uint8_t *in, size_t inlen)
+{
+    iosha_ctx ctx;
+    uint8_t b[8];
+
+    le64(b, index);
+    iosha_init(&ctx, IOSHA_TAG_LEAF);
+    iosha_absorb(&ctx, b, 8);
+    iosha_absorb(&ctx, in, inlen);
+    iosha_squeeze(&ctx, cv, IOSHA_TREE_CVBYTES);
+}
+
+/* Four consecutive full leaves starting at leaf `index` */
+static void iosha_tree_leaf_x4(uint8_t cv[4][IOSHA_TREE_CVBYTES], uint64_t index,
+                               const uint8_t *in)
+{
+    iosha_ctx_x4 ctx;
+    uint8_t b[4][8];
+
+    for (int j = 0; j < 4; ++j) le64(b[j], index + j);
+    iosha_init_x4(&ctx, IOSHA_TAG_LEAF);
+    iosha_absorb_x4(&ctx, b[0], b[1], b[2], b[3], 8);
+    iosha_absorb_x4(&ctx, in, in + IOSHA_TREE_LEAFBYTES,
+                    in + 2 * IOSHA_TREE_LEAFBYTES, in + 3 * IOSHA_TREE_LEAFBYTES,
+                    IOSHA_TREE_LEAFBYTES);
+    iosha_squeeze_x4(&ctx, cv[0], cv[1], cv[2], cv[3], IOSHA_TREE_CVBYTES);
+}
+
+void iosha_tree_bytes(const uint8_t *in, size_t inlen,
+                      uint8_t *out, size_t outlen)
+{
+    uint8_t cv[IOSHA_TREE_BATCH][IOSHA_TREE_CVBYTES];
+    uint8_t b[8];
+    iosha_ctx root;
+    size_t nleaves = inlen ? (inlen + IOSHA_TREE_LEAFBYTES - 1) / IOSHA_TREE_LEAFBYTES : 1;
+
+    iosha_init(&root, IOSHA_TAG_ROOT);
+    for (size_t first = 0; first < nleaves; first += IOSHA_TREE_BATCH) {
+        long ngroups, n = (long)(nleaves - first);
+        if (n > IOSHA_TREE_BATCH) n = IOSHA_TREE_BATCH;
+        ngroups = (n + 3) / 4;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long g = 0; g < ngroups; ++g) {
+            size_t leaf = first + 4 * (size_t)g;
+            size_t off = leaf * IOSHA_TREE_LEAFBYTES;
+
+            if (off + 4 * IOSHA_TREE_LEAFBYTES <= inlen) {
+                iosha_tree_leaf_x4(&cv[4 * g], leaf, in + off);
+                continue;
+            }
+            for (long j = 4 * g; j < n; ++j, ++leaf, off += IOSHA_TREE_LEAFBYTES) {
+                size_t len = inlen - off < IOSHA_TREE_LEAFBYTES ? inlen - off
+                                                                : IOSHA_TREE_LEAFBYTES;
+                iosha_tree_leaf(cv[j], leaf, in + off, len);
+            }
+        }
+
+        iosha_absorb(&root, &cv[0][0], (size_t)n * IOSHA_TREE_CVBYTES);
+    }
+
+    le64(b, (uint64_t)inlen);
+    iosha_absorb(&root, b, 8);
+    iosha_squeeze(&root, out, outlen);
+}
+
+/* Incremental tree hash with the same output as iosha_tree_bytes. Leaves
+   are closed as soon as they fill up; runs of four whole leaves inside one
+   update go through the x4 engine, but there is no threading here. */
+void iosha_tree_init(iosha_tree_ctx *ctx)
+{
+    iosha_init(&ctx->root, IOSHA_TAG_ROOT);
+    ctx->inlen = 0;
+}
+
+void iosha_tree_update(iosha_tree_ctx *ctx, const uint8_t *in, size_t inlen)
+{
+    uint8_t cv[4][IOSHA_TREE_CVBYTES];
+    uint8_t b[8];
+
+    while (inlen) {
+        size_t pos = (size_t)(ctx->inlen % IOSHA_TREE_LEAFBYTES);
+        size_t n = IOSHA_TREE_LEAFBYTES - pos;
+
+        if (pos == 0) {
+            uint64_t index = ctx->inlen / IOSHA_TREE_LEAFBYTES;
+            if (inlen >= 4 * IOSHA_TREE_LEAFBYTES) {
+                iosha_tree_leaf_x4(cv, index, in);
+                iosha_absorb(&ctx->root, &cv[0][0], sizeof(cv));
+                in += 4 * IOSHA_TREE_LEAFBYTES;
+                inlen -= 4 * IOSHA_TREE_LEAFBYTES;
+                ctx->inlen += 4 * IOSHA_TREE_LEAFBYTES;
+                continue;
+            }
+            le64(b, index);
+            iosha_init(&ctx->leaf, IOSHA_TAG_LEAF);
+            iosha_absorb(&ctx->leaf, b, 8);
+        }
+
+        if (n > inlen) n = inlen;
+        iosha_absorb(&ctx->leaf, in, n);
+        in += n;
+        inlen -= n;
+        ctx->inlen += n;
+
+        if (pos + n == IOSHA_TREE_LEAFBYTES) {
+            iosha_squeeze(&ctx->leaf, cv[0], IOSHA_TREE_CVBYTES);
+            iosha_absorb(&ctx->root, cv[0], IOSHA_TREE_CVBYTES);
+        }
+    }
+}
+
+void iosha_tree_final(iosha_tree_ctx *ctx, uint8_t *out, size_t outlen)
+{
+    uint8_t cv[IOSHA_TREE_CVBYTES];
+    uint8_t b[8];
+
+    /* Close a partial last leaf, or hash the single empty leaf */
+    if (ctx->inlen == 0) {
+        le64(b, 0);
+        iosha_init(&ctx->leaf, IOSHA_TAG_LEAF);
+        iosha_absorb(&ctx->leaf, b, 8);
+    }
+    if (ctx->inlen == 0 || ctx->inlen % IOSHA_TREE_LEAFBYTES) {
+        iosha_squeeze(&ctx->leaf, cv, IOSHA_TREE_CVBYTES);
+        iosha_absorb(&ctx->root, cv, IOSHA_TREE_CVBYTES);
+    }
+
+    le64(b, ctx->inlen);
+    iosha_absorb(&ctx->root, b, 8);
+    iosha_squeeze(&ctx->root, out, outlen);
+}
+
 
 
 
@@ -16,8 +16,32 @@ typedef struct {
     uint32_t rate;            /* byte position in current 64-byte block */
 } iosha_ctx;
 
+/* ---------- 4-way multi-buffer state ---------------------------- */
+/* Four independent duplex states, lane-interleaved: st[4*i + j] is
+   lane i of stream j. All four streams share idx/rate (lockstep). */
+typedef struct {
+    uint64_t st[4*16];
+    size_t   idx;
+    uint32_t rate;
+} iosha_ctx_x4;
+
+/* ---------- 8-way multi-buffer state ---------------------------- */
+/* Same layout with eight streams: st[8*i + j] is lane i of stream j. */
+typedef struct {
+    uint64_t st[8*16];
+    size_t   idx;
+    uint32_t rate;
+} iosha_ctx_x8;
+
 /* ---------- core helpers ----------------------------------------- */
+#ifdef IOSHA_STATS
+/* Number of single-state permutations run so far (x4 counts four) */
+extern unsigned long long iosha_permute_count;
+#endif
+
+void iosha_permute(uint64_t s[16]);
 void iosha_init(iosha_ctx *ctx, uint8_t tag);
+void iosha_clone(iosha_ctx *dst, const iosha_ctx *src);
 void iosha_init_128(iosha_ctx *ctx, uint8_t tag);
 void iosha_absorb(iosha_ctx *ctx, const uint8_t *in, size_t inlen);
 void iosha_absorb_128(iosha_ctx *ctx, const uint8_t *in, size_t inlen);
@@ -25,10 +49,70 @@ void iosha_absorb_128(iosha_ctx *ctx, const uint8_t *in, size_t inlen);
 void iosha_squeeze(iosha_ctx *ctx, uint8_t *out, size_t outlen);
 void iosha_squeeze_128(iosha_ctx *ctx, uint8_t *out, size_t outlen);
 
+/* Incremental XOF: pad once, then hand out whole rate-sized blocks */
+void iosha_finalize(iosha_ctx *ctx);
+void iosha_squeezeblocks(uint8_t *out, size_t nblocks, iosha_ctx *ctx);
+
+/* 4-way variants; each stream is bit-identical to the scalar calls */
+void iosha_permute_x4(uint64_t s[4*16]);
+void iosha_init_x4(iosha_ctx_x4 *ctx, uint8_t tag);
+void iosha_init_128_x4(iosha_ctx_x4 *ctx, uint8_t tag);
+void iosha_absorb_x4(iosha_ctx_x4 *ctx,
+                     const uint8_t *in0, const uint8_t *in1,
+                     const uint8_t *in2, const uint8_t *in3, size_t inlen);
+void iosha_squeeze_x4(iosha_ctx_x4 *ctx,
+                      uint8_t *out0, uint8_t *out1,
+                      uint8_t *out2, uint8_t *out3, size_t outlen);
+void iosha_finalize_x4(iosha_ctx_x4 *ctx);
+void iosha_squeezeblocks_x4(uint8_t *out0, uint8_t *out1,
+                            uint8_t *out2, uint8_t *out3,
+                            size_t nblocks, iosha_ctx_x4 *ctx);
+
+/* 8-way variants (AVX-512 when available, else two x4 halves) */
+int iosha_x8_native(void);
+void iosha_permute_x8(uint64_t s[8*16]);
+void iosha_init_x8(iosha_ctx_x8 *ctx, uint8_t tag);
+void iosha_init_128_x8(iosha_ctx_x8 *ctx, uint8_t tag);
+void iosha_absorb_x8(iosha_ctx_x8 *ctx,
+                     const uint8_t *in0, const uint8_t *in1,
+                     const uint8_t *in2, const uint8_t *in3,
+                     const uint8_t *in4, const uint8_t *in5,
+                     const uint8_t *in6, const uint8_t *in7, size_t inlen);
+void iosha_squeeze_x8(iosha_ctx_x8 *ctx,
+                      uint8_t *out0, uint8_t *out1,
+                      uint8_t *out2, uint8_t *out3,
+                      uint8_t *out4, uint8_t *out5,
+                      uint8_t *out6, uint8_t *out7, size_t outlen);
+void iosha_finalize_x8(iosha_ctx_x8 *ctx);
+void iosha_squeezeblocks_x8(uint8_t *out0, uint8_t *out1,
+                            uint8_t *out2, uint8_t *out3,
+                            uint8_t *out4, uint8_t *out5,
+                            uint8_t *out6, uint8_t *out7,
+                            size_t nblocks, iosha_ctx_x8 *ctx);
+
 /* One-shot convenience wrappers */
 void iosha_xof_bytes(const uint8_t *seed, size_t seedlen,
                      uint16_t nonce, uint8_t *out, size_t outlen);
 void iosha_crh_bytes(const uint8_t *in, size_t inlen,
                      uint8_t *out, size_t outlen);
 
+/* Tree-hashing mode: independent IOSHA_TREE_LEAFBYTES leaves (tag 0x03)
+   combined by a root sponge (tag 0x04). Parallel with OpenMP. */
+#ifndef IOSHA_TREE_LEAFBYTES
+#define IOSHA_TREE_LEAFBYTES 8192
+#endif
+void iosha_tree_bytes(const uint8_t *in, size_t inlen,
+                      uint8_t *out, size_t outlen);
+
+/* Streaming form of iosha_tree_bytes (sequential) */
+typedef struct {
+    iosha_ctx root;
+    iosha_ctx leaf;       /* current partial leaf */
+    uint64_t  inlen;      /* bytes absorbed so far */
+} iosha_tree_ctx;
+
+void iosha_tree_init(iosha_tree_ctx *ctx);
+void iosha_tree_update(iosha_tree_ctx *ctx, const uint8_t *in, size_t inlen);
+void iosha_tree_final(iosha_tree_ctx *ctx, uint8_t *out, size_t outlen);
+
 #endif /* IOSHA_H */
@@ -0,0 +1,131 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "matcache.h"
+#include "polyvec.h"
+#include "symmetric.h"
+
+static unsigned int bucket(const uint8_t rho[SEEDBYTES])
+{
+  return (rho[0] | (unsigned int)rho[1] << 8) & (MATCACHE_BUCKETS - 1);
+}
+
+static int same_key(const matcache_entry *e,
+                    const uint8_t rho[SEEDBYTES],
+                    const dilithium_symmetric *sym)
+{
+  unsigned int i;
+
+  if(e->sym != sym)
+    return 0;
+  for(i = 0; i < SEEDBYTES; ++i)
+    if(e->rho[i] != rho[i])
+      return 0;
+  return 1;
+}
+
+static void lru_unlink(dilithium_matrix_cache *cache, matcache_entry *e)
+{
+  if(e->prev)
+    e->prev->next = e->next;
+  else
+    cache->head = e->next;
+  if(e->next)
+    e->next->prev = e->prev;
+  else
+    cache->tail = e->prev;
+}
+
+static void lru_push(dilithium_matrix_cache *cache, matcache_entry *e)
+{
+  e->prev = NULL;
+  e->next = cache->head;
+  if(cache->head)
+    cache->head->prev = e;
+  else
+    cache->tail = e;
+  cache->head = e;
+}
+
+/*************************************************
+* Name:        matrix_cache_init
+*
+* Description: Set up an empty matrix cache in the given memory; the cache
+*              holds memlen / sizeof(matcache_entry) matrices, and with
+*              room for none every lookup misses.
+*
+* Arguments:   - dilithium_matrix_cache *cache: pointer to cache
+*              - void *mem: memory for the entries, aligned for them (e.g.
+*                from malloc); must outlive the cache
+*              - size_t memlen: length of mem in bytes (the budget)
+**************************************************/
+void matrix_cache_init(dilithium_matrix_cache *cache, void *mem, size_t memlen)
+{
+  unsigned int i;
+
+  cache->entries = (matcache_entry *)mem;
+  cache->nentries = mem ? memlen / sizeof(matcache_entry) : 0;
+  cache->used = 0;
+  cache->head = cache->tail = NULL;
+  for(i = 0; i < MATCACHE_BUCKETS; ++i)
+    cache->buckets[i] = NULL;
+  cache->hits = cache->misses = 0;
+}
+
+/*************************************************
+* Name:        matrix_cache_get
+*
+* Description: Look up ExpandA(rho) under the given backend; a miss
+*              expands it into a free entry or over the least recently
+*              used one.
+*
+* Arguments:   - dilithium_matrix_cache *cache: pointer to cache
+*              - const uint8_t rho[]: byte array with seed of length SEEDBYTES
+*              - const dilithium_symmetric *sym: hash backend
+*
+* Returns the K rows of A, valid until the next lookup in this cache, or
+* NULL if the cache has no room for an entry.
+**************************************************/
+const polyvecl *matrix_cache_get(dilithium_matrix_cache *cache,
+                                 const uint8_t rho[SEEDBYTES],
+                                 const dilithium_symmetric *sym)
+{
+  unsigned int i, b;
+  matcache_entry *e, **p;
+
+  if(!cache->nentries)
+    return NULL;
+
+  b = bucket(rho);
+  for(e = cache->buckets[b]; e; e = e->chain) {
+    if(same_key(e, rho, sym)) {
+      cache->hits += 1;
+      lru_unlink(cache, e);
+      lru_push(cache, e);
+      return e->mat;
+    }
+  }
+
+  cache->misses += 1;
+  if(cache->used < cache->nentries) {
+    e = &cache->entries[cache->used++];
+  }
+  else {
+    /* Evict the tail from its bucket and the list */
+    e = cache->tail;
+    for(p = &cache->buckets[bucket(e->rho)]; *p != e; p = &(*p)->chain)
+      ;
+    *p = e->chain;
+    lru_unlink(cache, e);
+  }
+
+  e->sym = sym;
+  for(i = 0; i < SEEDBYTES; ++i)
+    e->rho[i] = rho[i];
+  polyvec_matrix_expand(e->mat, rho, sym);
+
+  e->chain = cache->buckets[b];
+  cache->buckets[b] = e;
+  lru_push(cache, e);
+  return e->mat;
+}
@@ -0,0 +1,43 @@
+#ifndef MATCACHE_H
+#define MATCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "params.h"
+#include "polyvec.h"
+#include "symmetric.h"
+
+/* Hash buckets of the matrix cache, a power of two; rho is uniform, so
+   its first bytes index them directly */
+#ifndef MATCACHE_BUCKETS
+#define MATCACHE_BUCKETS 256
+#endif
+
+/* One expanded A = ExpandA(rho) under one backend */
+typedef struct matcache_entry {
+  struct matcache_entry *prev, *next;  /* LRU list, most recent first */
+  struct matcache_entry *chain;        /* bucket chain */
+  const dilithium_symmetric *sym;
+  uint8_t rho[SEEDBYTES];
+  polyvecl mat[K];
+} matcache_entry;
+
+/* Bounded LRU cache of expanded matrices in caller-provided memory.
+   Not thread-safe: use one cache per thread or serialize the calls. */
+typedef struct {
+  matcache_entry *entries;
+  size_t nentries, used;
+  matcache_entry *head, *tail;
+  matcache_entry *buckets[MATCACHE_BUCKETS];
+  unsigned long long hits, misses;
+} dilithium_matrix_cache;
+
+#define matrix_cache_init DILITHIUM_NAMESPACE(matrix_cache_init)
+void matrix_cache_init(dilithium_matrix_cache *cache, void *mem, size_t memlen);
+
+#define matrix_cache_get DILITHIUM_NAMESPACE(matrix_cache_get)
+const polyvecl *matrix_cache_get(dilithium_matrix_cache *cache,
+                                 const uint8_t rho[SEEDBYTES],
+                                 const dilithium_symmetric *sym);
+
+#endif
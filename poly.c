@@ -4,6 +4,7 @@
 #include "ntt.h"
 #include "reduce.h"
 #include "rounding.h"
+#include "rejsample.h"
 #include "symmetric.h"
 
 #ifdef DBENCH
@@ -17,6 +18,13 @@ extern uint64_t *tred, *tadd, *tmul, *tround, *tsample, *tpack;
 #define DBENCH_STOP(t)
 #endif
 
+/* The squeezelanes paths parse the stream straight out of the sponge's
+   uint64_t lanes, which only reads as the squeezed byte stream (and as
+   little-endian words) on little-endian hosts */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define POLY_LANES_LE
+#endif
+
 /*************************************************
 * Name:        poly_reduce
 *
@@ -292,44 +300,6 @@ int poly_chknorm(const poly *a, int32_t B) {
   return 0;
 }
 
-/*************************************************
-* Name:        rej_uniform
-*
-* Description: Sample uniformly random coefficients in [0, Q-1] by
-*              performing rejection sampling on array of random bytes.
-*
-* Arguments:   - int32_t *a: pointer to output array (allocated)
-*              - unsigned int len: number of coefficients to be sampled
-*              - const uint8_t *buf: array of random bytes
-*              - unsigned int buflen: length of array of random bytes
-*
-* Returns number of sampled coefficients. Can be smaller than len if not enough
-* random bytes were given.
-**************************************************/
-static unsigned int rej_uniform(int32_t *a,
-                                unsigned int len,
-                                const uint8_t *buf,
-                                unsigned int buflen)
-{
-  unsigned int ctr, pos;
-  uint32_t t;
-  DBENCH_START();
-
-  ctr = pos = 0;
-  while(ctr < len && pos + 3 <= buflen) {
-    t  = buf[pos++];
-    t |= (uint32_t)buf[pos++] << 8;
-    t |= (uint32_t)buf[pos++] << 16;
-    t &= 0x7FFFFF;
-
-    if(t < Q)
-      a[ctr++] = t;
-  }
-
-  DBENCH_STOP(*tsample);
-  return ctr;
-}
-
 /*************************************************
 * Name:        poly_uniform
 *
@@ -340,19 +310,34 @@ static unsigned int rej_uniform(int32_t *a,
 * Arguments:   - poly *a: pointer to output polynomial
 *              - const uint8_t seed[]: byte array with seed of length SEEDBYTES
 *              - uint16_t nonce: 2-byte nonce
+*              - const dilithium_symmetric *sym: hash backend
 **************************************************/
 #define POLY_UNIFORM_NBLOCKS ((768 + STREAM128_BLOCKBYTES - 1)/STREAM128_BLOCKBYTES)
 void poly_uniform(poly *a,
                   const uint8_t seed[SEEDBYTES],
-                  uint16_t nonce)
+                  uint16_t nonce,
+                  const dilithium_symmetric *sym)
 {
   unsigned int i, ctr, off;
   unsigned int buflen = POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES;
   uint8_t buf[POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES + 2];
   stream128_state state;
 
-  stream128_init(&state, seed, nonce);
-  stream128_squeezeblocks(buf, POLY_UNIFORM_NBLOCKS, &state);
+  sym->stream128_init(&state, seed, nonce);
+
+#if STREAM128_BLOCKBYTES % 3 == 0 && defined(POLY_LANES_LE)
+  /* No candidate straddles a block, so parse each one in place */
+  if(sym->stream128_squeezelanes) {
+    ctr = 0;
+    while(ctr < N)
+      ctr += rej_uniform(a->coeffs + ctr, N - ctr,
+                         (const uint8_t *)sym->stream128_squeezelanes(&state),
+                         STREAM128_BLOCKBYTES);
+    return;
+  }
+#endif
+
+  sym->stream128_squeezeblocks(buf, POLY_UNIFORM_NBLOCKS, &state);
 
   ctr = rej_uniform(a->coeffs, N, buf, buflen);
 
@@ -361,59 +346,125 @@ void poly_uniform(poly *a,
     for(i = 0; i < off; ++i)
       buf[i] = buf[buflen - off + i];
 
-    stream128_squeezeblocks(buf + off, 1, &state);
+    sym->stream128_squeezeblocks(buf + off, 1, &state);
     buflen = STREAM128_BLOCKBYTES + off;
     ctr += rej_uniform(a->coeffs + ctr, N - ctr, buf, buflen);
   }
 }
 
 /*************************************************
-* Name:        rej_eta
+* Name:        poly_uniform_4x
 *
-* Description: Sample uniformly random coefficients in [-ETA, ETA] by
-*              performing rejection sampling on array of random bytes.
+* Description: Four poly_uniform calls at once on the backend's 4-way
+*              stream; each output equals poly_uniform with its nonce.
+*              Lanes that need more bytes keep squeezing until all four
+*              polynomials are complete.
 *
-* Arguments:   - int32_t *a: pointer to output array (allocated)
-*              - unsigned int len: number of coefficients to be sampled
-*              - const uint8_t *buf: array of random bytes
-*              - unsigned int buflen: length of array of random bytes
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length SEEDBYTES
+*              - uint16_t nonce0, ..., nonce3: 2-byte nonces
+*              - const dilithium_symmetric *sym: hash backend with 4-way
+*                streams
+**************************************************/
+void poly_uniform_4x(poly *a0,
+                     poly *a1,
+                     poly *a2,
+                     poly *a3,
+                     const uint8_t seed[SEEDBYTES],
+                     uint16_t nonce0,
+                     uint16_t nonce1,
+                     uint16_t nonce2,
+                     uint16_t nonce3,
+                     const dilithium_symmetric *sym)
+{
+  unsigned int i, j, off;
+  unsigned int blockbytes = sym->stream128x4_blockbytes;
+  unsigned int buflen = (768 + blockbytes - 1)/blockbytes*blockbytes;
+  unsigned int ctr[4];
+  uint8_t buf[4][768 + STREAMX4_MAXBLOCKBYTES + 2];
+  uint8_t *out[4];
+  uint16_t nonce[4];
+  poly *a[4];
+  stream_x4_state state;
+
+  a[0] = a0; a[1] = a1; a[2] = a2; a[3] = a3;
+  nonce[0] = nonce0; nonce[1] = nonce1; nonce[2] = nonce2; nonce[3] = nonce3;
+  for(j = 0; j < 4; ++j)
+    out[j] = buf[j];
+
+  sym->stream128x4_init(&state, seed, nonce);
+  sym->stream128x4_squeezeblocks(out, buflen/blockbytes, &state);
+
+  for(j = 0; j < 4; ++j)
+    ctr[j] = rej_uniform(a[j]->coeffs, N, buf[j], buflen);
+
+  while(ctr[0] < N || ctr[1] < N || ctr[2] < N || ctr[3] < N) {
+    off = buflen % 3;
+    for(j = 0; j < 4; ++j) {
+      for(i = 0; i < off; ++i)
+        buf[j][i] = buf[j][buflen - off + i];
+      out[j] = buf[j] + off;
+    }
+
+    sym->stream128x4_squeezeblocks(out, 1, &state);
+    buflen = blockbytes + off;
+    for(j = 0; j < 4; ++j)
+      ctr[j] += rej_uniform(a[j]->coeffs + ctr[j], N - ctr[j], buf[j], buflen);
+  }
+}
+
+/*************************************************
+* Name:        poly_uniform_8x
+*
+* Description: Eight poly_uniform calls at once on the backend's 8-way
+*              stream; each output equals poly_uniform with its nonce.
 *
-* Returns number of sampled coefficients. Can be smaller than len if not enough
-* random bytes were given.
+* Arguments:   - poly *const a[8]: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length SEEDBYTES
+*              - const uint16_t nonce[8]: 2-byte nonces
+*              - const dilithium_symmetric *sym: hash backend with 8-way
+*                streams
 **************************************************/
-static unsigned int rej_eta(int32_t *a,
-                            unsigned int len,
-                            const uint8_t *buf,
-                            unsigned int buflen)
+void poly_uniform_8x(poly *const a[8],
+                     const uint8_t seed[SEEDBYTES],
+                     const uint16_t nonce[8],
+                     const dilithium_symmetric *sym)
 {
-  unsigned int ctr, pos;
-  uint32_t t0, t1;
-  DBENCH_START();
+  unsigned int i, j, off, done;
+  unsigned int buflen = POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES;
+  unsigned int ctr[8];
+  uint8_t buf[8][POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES + 2];
+  uint8_t *out[8];
+  stream_x8_state state;
 
-  ctr = pos = 0;
-  while(ctr < len && pos < buflen) {
-    t0 = buf[pos] & 0x0F;
-    t1 = buf[pos++] >> 4;
+  for(j = 0; j < 8; ++j)
+    out[j] = buf[j];
 
-#if ETA == 2
-    if(t0 < 15) {
-      t0 = t0 - (205*t0 >> 10)*5;
-      a[ctr++] = 2 - t0;
+  sym->stream128x8_init(&state, seed, nonce);
+  sym->stream128x8_squeezeblocks(out, POLY_UNIFORM_NBLOCKS, &state);
+
+  done = 1;
+  for(j = 0; j < 8; ++j) {
+    ctr[j] = rej_uniform(a[j]->coeffs, N, buf[j], buflen);
+    done &= ctr[j] == N;
+  }
+
+  while(!done) {
+    off = buflen % 3;
+    for(j = 0; j < 8; ++j) {
+      for(i = 0; i < off; ++i)
+        buf[j][i] = buf[j][buflen - off + i];
+      out[j] = buf[j] + off;
     }
-    if(t1 < 15 && ctr < len) {
-      t1 = t1 - (205*t1 >> 10)*5;
-      a[ctr++] = 2 - t1;
+
+    sym->stream128x8_squeezeblocks(out, 1, &state);
+    buflen = STREAM128_BLOCKBYTES + off;
+    done = 1;
+    for(j = 0; j < 8; ++j) {
+      ctr[j] += rej_uniform(a[j]->coeffs + ctr[j], N - ctr[j], buf[j], buflen);
+      done &= ctr[j] == N;
     }
-#elif ETA == 4
-    if(t0 < 9)
-      a[ctr++] = 4 - t0;
-    if(t1 < 9 && ctr < len)
-      a[ctr++] = 4 - t1;
-#endif
   }
-
-  DBENCH_STOP(*tsample);
-  return ctr;
 }
 
 /*************************************************
@@ -426,32 +477,98 @@ static unsigned int rej_eta(int32_t *a,
 * Arguments:   - poly *a: pointer to output polynomial
 *              - const uint8_t seed[]: byte array with seed of length CRHBYTES
 *              - uint16_t nonce: 2-byte nonce
+*              - const dilithium_symmetric *sym: hash backend
 **************************************************/
 #if ETA == 2
-#define POLY_UNIFORM_ETA_NBLOCKS ((136 + STREAM256_BLOCKBYTES - 1)/STREAM256_BLOCKBYTES)
+#define POLY_UNIFORM_ETA_BYTES 136
 #elif ETA == 4
-#define POLY_UNIFORM_ETA_NBLOCKS ((227 + STREAM256_BLOCKBYTES - 1)/STREAM256_BLOCKBYTES)
+#define POLY_UNIFORM_ETA_BYTES 227
 #endif
+#define POLY_UNIFORM_ETA_NBLOCKS ((POLY_UNIFORM_ETA_BYTES + STREAM256_BLOCKBYTES - 1)/STREAM256_BLOCKBYTES)
 void poly_uniform_eta(poly *a,
                       const uint8_t seed[CRHBYTES],
-                      uint16_t nonce)
+                      uint16_t nonce,
+                      const dilithium_symmetric *sym)
 {
   unsigned int ctr;
   unsigned int buflen = POLY_UNIFORM_ETA_NBLOCKS*STREAM256_BLOCKBYTES;
   uint8_t buf[POLY_UNIFORM_ETA_NBLOCKS*STREAM256_BLOCKBYTES];
   stream256_state state;
 
-  stream256_init(&state, seed, nonce);
-  stream256_squeezeblocks(buf, POLY_UNIFORM_ETA_NBLOCKS, &state);
+  sym->stream256_init(&state, seed, nonce);
+
+#ifdef POLY_LANES_LE
+  if(sym->stream256_squeezelanes) {
+    ctr = 0;
+    while(ctr < N)
+      ctr += rej_eta(a->coeffs + ctr, N - ctr,
+                     (const uint8_t *)sym->stream256_squeezelanes(&state),
+                     STREAM256_BLOCKBYTES);
+    return;
+  }
+#endif
+
+  sym->stream256_squeezeblocks(buf, POLY_UNIFORM_ETA_NBLOCKS, &state);
 
   ctr = rej_eta(a->coeffs, N, buf, buflen);
 
   while(ctr < N) {
-    stream256_squeezeblocks(buf, 1, &state);
+    sym->stream256_squeezeblocks(buf, 1, &state);
     ctr += rej_eta(a->coeffs + ctr, N - ctr, buf, STREAM256_BLOCKBYTES);
   }
 }
 
+/*************************************************
+* Name:        poly_uniform_eta_4x
+*
+* Description: Four poly_uniform_eta calls at once on the backend's 4-way
+*              stream; each output equals poly_uniform_eta with its nonce.
+*
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length CRHBYTES
+*              - uint16_t nonce0, ..., nonce3: 2-byte nonces
+*              - const dilithium_symmetric *sym: hash backend with 4-way
+*                streams
+**************************************************/
+void poly_uniform_eta_4x(poly *a0,
+                         poly *a1,
+                         poly *a2,
+                         poly *a3,
+                         const uint8_t seed[CRHBYTES],
+                         uint16_t nonce0,
+                         uint16_t nonce1,
+                         uint16_t nonce2,
+                         uint16_t nonce3,
+                         const dilithium_symmetric *sym)
+{
+  unsigned int j;
+  unsigned int blockbytes = sym->stream256x4_blockbytes;
+  unsigned int buflen = (POLY_UNIFORM_ETA_BYTES + blockbytes - 1)/blockbytes*blockbytes;
+  unsigned int ctr[4];
+  uint8_t buf[4][POLY_UNIFORM_ETA_BYTES + STREAMX4_MAXBLOCKBYTES];
+  uint8_t *out[4];
+  uint16_t nonce[4];
+  poly *a[4];
+  stream_x4_state state;
+
+  a[0] = a0; a[1] = a1; a[2] = a2; a[3] = a3;
+  nonce[0] = nonce0; nonce[1] = nonce1; nonce[2] = nonce2; nonce[3] = nonce3;
+  for(j = 0; j < 4; ++j)
+    out[j] = buf[j];
+
+  sym->stream256x4_init(&state, seed, nonce);
+  sym->stream256x4_squeezeblocks(out, buflen/blockbytes, &state);
+
+  for(j = 0; j < 4; ++j)
+    ctr[j] = rej_eta(a[j]->coeffs, N, buf[j], buflen);
+
+  while(ctr[0] < N || ctr[1] < N || ctr[2] < N || ctr[3] < N) {
+    sym->stream256x4_squeezeblocks(out, 1, &state);
+    for(j = 0; j < 4; ++j)
+      ctr[j] += rej_eta(a[j]->coeffs + ctr[j], N - ctr[j], buf[j], blockbytes);
+  }
+}
+
 /*************************************************
 * Name:        poly_uniform_gamma1m1
 *
@@ -462,20 +579,105 @@ void poly_uniform_eta(poly *a,
 * Arguments:   - poly *a: pointer to output polynomial
 *              - const uint8_t seed[]: byte array with seed of length CRHBYTES
 *              - uint16_t nonce: 16-bit nonce
+*              - const dilithium_symmetric *sym: hash backend
 **************************************************/
 #define POLY_UNIFORM_GAMMA1_NBLOCKS ((POLYZ_PACKEDBYTES + STREAM256_BLOCKBYTES - 1)/STREAM256_BLOCKBYTES)
+#if GAMMA1 == (1 << 17)
+#define POLYZ_BITS 18
+#elif GAMMA1 == (1 << 19)
+#define POLYZ_BITS 20
+#endif
 void poly_uniform_gamma1(poly *a,
                          const uint8_t seed[CRHBYTES],
-                         uint16_t nonce)
+                         uint16_t nonce,
+                         const dilithium_symmetric *sym)
 {
   uint8_t buf[POLY_UNIFORM_GAMMA1_NBLOCKS*STREAM256_BLOCKBYTES];
   stream256_state state;
 
-  stream256_init(&state, seed, nonce);
-  stream256_squeezeblocks(buf, POLY_UNIFORM_GAMMA1_NBLOCKS, &state);
+  sym->stream256_init(&state, seed, nonce);
+
+#ifdef POLY_LANES_LE
+  /* polyz_unpack on the lane words: the packed stream is little endian,
+     so z is read off a bit accumulator refilled one lane at a time */
+  if(sym->stream256_squeezelanes) {
+    unsigned int i, j, bits;
+    uint64_t t, w;
+    const uint64_t *lanes = NULL;
+
+    j = STREAM256_BLOCKBYTES/8;
+    t = 0;
+    bits = 0;
+    for(i = 0; i < N; ++i) {
+      if(bits < POLYZ_BITS) {
+        if(j == STREAM256_BLOCKBYTES/8) {
+          lanes = sym->stream256_squeezelanes(&state);
+          j = 0;
+        }
+        w = lanes[j++];
+        t |= w << bits;
+        a->coeffs[i] = GAMMA1 - (int32_t)(t & ((1 << POLYZ_BITS) - 1));
+        t = w >> (POLYZ_BITS - bits);
+        bits += 64 - POLYZ_BITS;
+      }
+      else {
+        a->coeffs[i] = GAMMA1 - (int32_t)(t & ((1 << POLYZ_BITS) - 1));
+        t >>= POLYZ_BITS;
+        bits -= POLYZ_BITS;
+      }
+    }
+    return;
+  }
+#endif
+
+  sym->stream256_squeezeblocks(buf, POLY_UNIFORM_GAMMA1_NBLOCKS, &state);
   polyz_unpack(a, buf);
 }
 
+/*************************************************
+* Name:        poly_uniform_gamma1_4x
+*
+* Description: Four poly_uniform_gamma1 calls at once on the backend's
+*              4-way stream.
+*
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length CRHBYTES
+*              - uint16_t nonce0, ..., nonce3: 16-bit nonces
+*              - const dilithium_symmetric *sym: hash backend with 4-way
+*                streams
+**************************************************/
+void poly_uniform_gamma1_4x(poly *a0,
+                            poly *a1,
+                            poly *a2,
+                            poly *a3,
+                            const uint8_t seed[CRHBYTES],
+                            uint16_t nonce0,
+                            uint16_t nonce1,
+                            uint16_t nonce2,
+                            uint16_t nonce3,
+                            const dilithium_symmetric *sym)
+{
+  unsigned int j;
+  unsigned int blockbytes = sym->stream256x4_blockbytes;
+  uint8_t buf[4][POLYZ_PACKEDBYTES + STREAMX4_MAXBLOCKBYTES];
+  uint8_t *out[4];
+  uint16_t nonce[4];
+  stream_x4_state state;
+
+  nonce[0] = nonce0; nonce[1] = nonce1; nonce[2] = nonce2; nonce[3] = nonce3;
+  for(j = 0; j < 4; ++j)
+    out[j] = buf[j];
+
+  sym->stream256x4_init(&state, seed, nonce);
+  sym->stream256x4_squeezeblocks(out,
+                                 (POLYZ_PACKEDBYTES + blockbytes - 1)/blockbytes,
+                                 &state);
+  polyz_unpack(a0, buf[0]);
+  polyz_unpack(a1, buf[1]);
+  polyz_unpack(a2, buf[2]);
+  polyz_unpack(a3, buf[3]);
+}
+
 /*************************************************
 * Name:        challenge
 *
@@ -485,18 +687,21 @@ void poly_uniform_gamma1(poly *a,
 *
 * Arguments:   - poly *c: pointer to output polynomial
 *              - const uint8_t mu[]: byte array containing seed of length CTILDEBYTES
+*              - const dilithium_symmetric *sym: hash backend
 **************************************************/
-void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES])
+void poly_challenge(poly *c,
+                    const uint8_t seed[CTILDEBYTES],
+                    const dilithium_symmetric *sym)
 {
     unsigned int i, b, pos;
     uint64_t signs;
     uint8_t  buf[64];                 /* IOSHA rate = 64 bytes        */
-    iosha_ctx ctx;
+    crh_state ctx;
 
-    /* --- hash (seed) with domain tag 0x02 = CRH ------------------ */
-    iosha_init(&ctx, 0x02);
-    iosha_absorb(&ctx, seed, CTILDEBYTES);
-    iosha_squeeze(&ctx, buf, 64);     /* first 32-byte block          */
+    /* --- hash (seed) with the CRH ---------------------------------- */
+    sym->crh_init(&ctx);
+    sym->crh_absorb(&ctx, seed, CTILDEBYTES);
+    sym->crh_squeeze(&ctx, buf, 64);
 
     signs = 0;
     for (i = 0; i < 8; ++i)
@@ -510,7 +715,7 @@ void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES])
     for (i = N - TAU; i < N; ++i) {
         do {
             if (pos >= 64) {          /* need more XOF output?        */
-                iosha_squeeze(&ctx, buf, 64);
+                sym->crh_squeeze(&ctx, buf, 64);
                 pos = 0;
             }
             b = buf[pos++];
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "params.h"
+#include "symmetric.h"
 
 typedef struct {
   int32_t coeffs[N];
@@ -41,17 +42,64 @@ int poly_chknorm(const poly *a, int32_t B);
 #define poly_uniform DILITHIUM_NAMESPACE(poly_uniform)
 void poly_uniform(poly *a,
                   const uint8_t seed[SEEDBYTES],
-                  uint16_t nonce);
+                  uint16_t nonce,
+                  const dilithium_symmetric *sym);
 #define poly_uniform_eta DILITHIUM_NAMESPACE(poly_uniform_eta)
 void poly_uniform_eta(poly *a,
                       const uint8_t seed[CRHBYTES],
-                      uint16_t nonce);
+                      uint16_t nonce,
+                      const dilithium_symmetric *sym);
 #define poly_uniform_gamma1 DILITHIUM_NAMESPACE(poly_uniform_gamma1)
 void poly_uniform_gamma1(poly *a,
                          const uint8_t seed[CRHBYTES],
-                         uint16_t nonce);
+                         uint16_t nonce,
+                         const dilithium_symmetric *sym);
+
+/* Four samples at once; only for backends with 4-way streams */
+#define poly_uniform_4x DILITHIUM_NAMESPACE(poly_uniform_4x)
+void poly_uniform_4x(poly *a0,
+                     poly *a1,
+                     poly *a2,
+                     poly *a3,
+                     const uint8_t seed[SEEDBYTES],
+                     uint16_t nonce0,
+                     uint16_t nonce1,
+                     uint16_t nonce2,
+                     uint16_t nonce3,
+                     const dilithium_symmetric *sym);
+/* Eight samples at once; only for backends with 8-way streams */
+#define poly_uniform_8x DILITHIUM_NAMESPACE(poly_uniform_8x)
+void poly_uniform_8x(poly *const a[8],
+                     const uint8_t seed[SEEDBYTES],
+                     const uint16_t nonce[8],
+                     const dilithium_symmetric *sym);
+#define poly_uniform_eta_4x DILITHIUM_NAMESPACE(poly_uniform_eta_4x)
+void poly_uniform_eta_4x(poly *a0,
+                         poly *a1,
+                         poly *a2,
+                         poly *a3,
+                         const uint8_t seed[CRHBYTES],
+                         uint16_t nonce0,
+                         uint16_t nonce1,
+                         uint16_t nonce2,
+                         uint16_t nonce3,
+                         const dilithium_symmetric *sym);
+#define poly_uniform_gamma1_4x DILITHIUM_NAMESPACE(poly_uniform_gamma1_4x)
+void poly_uniform_gamma1_4x(poly *a0,
+                            poly *a1,
+                            poly *a2,
+                            poly *a3,
+                            const uint8_t seed[CRHBYTES],
+                            uint16_t nonce0,
+                            uint16_t nonce1,
+                            uint16_t nonce2,
+                            uint16_t nonce3,
+                            const dilithium_symmetric *sym);
+
 #define poly_challenge DILITHIUM_NAMESPACE(poly_challenge)
-void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES]);
+void poly_challenge(poly *c,
+                    const uint8_t seed[CTILDEBYTES],
+                    const dilithium_symmetric *sym);
 
 #define polyeta_pack DILITHIUM_NAMESPACE(polyeta_pack)
 void polyeta_pack(uint8_t *r, const poly *a);
@@ -10,15 +10,41 @@
 *              random coefficients a_{i,j} by performing rejection
 *              sampling on the output stream of SHAKE128(rho|j|i)
 *
+*              Entries are sampled eight at a time when the backend has
+*              8-way streams and the CPU has AVX-512 (elsewhere the 8-way
+*              permutation is two 4-way halves), else four at a time when
+*              it has 4-way streams.
+*
 * Arguments:   - polyvecl mat[K]: output matrix
 *              - const uint8_t rho[]: byte array containing seed rho
+*              - const dilithium_symmetric *sym: hash backend
 **************************************************/
-void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES]) {
-  unsigned int i, j;
+#define MAT(k) (&mat[(k)/L].vec[(k)%L])
+#define MAT_NONCE(k) ((((k)/L) << 8) + (k)%L)
+void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES],
+                           const dilithium_symmetric *sym) {
+  unsigned int j, k = 0;
+  uint16_t nonce[8];
+  poly *a[8];
+
+  if(sym->stream128x8_init && iosha_x8_native()) {
+    for(; k + 8 <= K*L; k += 8) {
+      for(j = 0; j < 8; ++j) {
+        a[j] = MAT(k+j);
+        nonce[j] = MAT_NONCE(k+j);
+      }
+      poly_uniform_8x(a, rho, nonce, sym);
+    }
+  }
 
-  for(i = 0; i < K; ++i)
-    for(j = 0; j < L; ++j)
-      poly_uniform(&mat[i].vec[j], rho, (i << 8) + j);
+  if(sym->stream128x4_init)
+    for(; k + 4 <= K*L; k += 4)
+      poly_uniform_4x(MAT(k), MAT(k+1), MAT(k+2), MAT(k+3), rho,
+                      MAT_NONCE(k), MAT_NONCE(k+1), MAT_NONCE(k+2),
+                      MAT_NONCE(k+3), sym);
+
+  for(; k < K*L; ++k)
+    poly_uniform(MAT(k), rho, MAT_NONCE(k), sym);
 }
 
 void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], const polyvecl *v) {
@@ -32,18 +58,32 @@ void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], con
 /************ Vectors of polynomials of length L **************/
 /**************************************************************/
 
-void polyvecl_uniform_eta(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
-  unsigned int i;
+void polyvecl_uniform_eta(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                          const dilithium_symmetric *sym) {
+  unsigned int i = 0;
 
-  for(i = 0; i < L; ++i)
-    poly_uniform_eta(&v->vec[i], seed, nonce++);
+  if(sym->stream256x4_init)
+    for(; i + 4 <= L; i += 4)
+      poly_uniform_eta_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3],
+                          seed, nonce + i, nonce + i + 1, nonce + i + 2,
+                          nonce + i + 3, sym);
+
+  for(; i < L; ++i)
+    poly_uniform_eta(&v->vec[i], seed, nonce + i, sym);
 }
 
-void polyvecl_uniform_gamma1(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
-  unsigned int i;
+void polyvecl_uniform_gamma1(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                             const dilithium_symmetric *sym) {
+  unsigned int i = 0;
 
-  for(i = 0; i < L; ++i)
-    poly_uniform_gamma1(&v->vec[i], seed, L*nonce + i);
+  if(sym->stream256x4_init)
+    for(; i + 4 <= L; i += 4)
+      poly_uniform_gamma1_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3],
+                             seed, L*nonce + i, L*nonce + i + 1,
+                             L*nonce + i + 2, L*nonce + i + 3, sym);
+
+  for(; i < L; ++i)
+    poly_uniform_gamma1(&v->vec[i], seed, L*nonce + i, sym);
 }
 
 void polyvecl_reduce(polyvecl *v) {
@@ -99,6 +139,23 @@ void polyvecl_pointwise_poly_montgomery(polyvecl *r, const poly *a, const polyve
     poly_pointwise_montgomery(&r->vec[i], a, &v->vec[i]);
 }
 
+/*************************************************
+* Name:        polyvecl_sparse_mul_add
+*
+* Description: r += c*v for a sparse challenge c; normal domain, no
+*              reduction.
+*
+* Arguments:   - polyvecl *r: pointer to input/output vector
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const polyvecl *v: pointer to input vector
+**************************************************/
+void polyvecl_sparse_mul_add(polyvecl *r, const poly_sparse *c, const polyvecl *v) {
+  unsigned int i;
+
+  for(i = 0; i < L; ++i)
+    poly_sparse_mul_add(&r->vec[i], c, &v->vec[i]);
+}
+
 /*************************************************
 * Name:        polyvecl_pointwise_acc_montgomery
 *
@@ -150,11 +207,18 @@ int polyvecl_chknorm(const polyvecl *v, int32_t bound)  {
 /************ Vectors of polynomials of length K **************/
 /**************************************************************/
 
-void polyveck_uniform_eta(polyveck *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
-  unsigned int i;
+void polyveck_uniform_eta(polyveck *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                          const dilithium_symmetric *sym) {
+  unsigned int i = 0;
 
-  for(i = 0; i < K; ++i)
-    poly_uniform_eta(&v->vec[i], seed, nonce++);
+  if(sym->stream256x4_init)
+    for(; i + 4 <= K; i += 4)
+      poly_uniform_eta_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3],
+                          seed, nonce + i, nonce + i + 1, nonce + i + 2,
+                          nonce + i + 3, sym);
+
+  for(; i < K; ++i)
+    poly_uniform_eta(&v->vec[i], seed, nonce + i, sym);
 }
 
 /*************************************************
@@ -275,6 +339,40 @@ void polyveck_pointwise_poly_montgomery(polyveck *r, const poly *a, const polyve
     poly_pointwise_montgomery(&r->vec[i], a, &v->vec[i]);
 }
 
+/*************************************************
+* Name:        polyveck_sparse_mul
+*
+* Description: r = c*v for a sparse challenge c; normal domain, no
+*              reduction.
+*
+* Arguments:   - polyveck *r: pointer to output vector
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const polyveck *v: pointer to input vector
+**************************************************/
+void polyveck_sparse_mul(polyveck *r, const poly_sparse *c, const polyveck *v) {
+  unsigned int i;
+
+  for(i = 0; i < K; ++i)
+    poly_sparse_mul(&r->vec[i], c, &v->vec[i]);
+}
+
+/*************************************************
+* Name:        polyveck_sparse_mul_sub
+*
+* Description: r -= c*v for a sparse challenge c; normal domain, no
+*              reduction.
+*
+* Arguments:   - polyveck *r: pointer to input/output vector
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const polyveck *v: pointer to input vector
+**************************************************/
+void polyveck_sparse_mul_sub(polyveck *r, const poly_sparse *c, const polyveck *v) {
+  unsigned int i;
+
+  for(i = 0; i < K; ++i)
+    poly_sparse_mul_sub(&r->vec[i], c, &v->vec[i]);
+}
+
 
 /*************************************************
 * Name:        polyveck_chknorm
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "params.h"
 #include "poly.h"
+#include "sparse.h"
 
 /* Vectors of polynomials of length L */
 typedef struct {
@@ -11,10 +12,12 @@ typedef struct {
 } polyvecl;
 
 #define polyvecl_uniform_eta DILITHIUM_NAMESPACE(polyvecl_uniform_eta)
-void polyvecl_uniform_eta(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce);
+void polyvecl_uniform_eta(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                          const dilithium_symmetric *sym);
 
 #define polyvecl_uniform_gamma1 DILITHIUM_NAMESPACE(polyvecl_uniform_gamma1)
-void polyvecl_uniform_gamma1(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce);
+void polyvecl_uniform_gamma1(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                             const dilithium_symmetric *sym);
 
 #define polyvecl_reduce DILITHIUM_NAMESPACE(polyvecl_reduce)
 void polyvecl_reduce(polyvecl *v);
@@ -35,6 +38,9 @@ void polyvecl_pointwise_acc_montgomery(poly *w,
                                        const polyvecl *v);
 
 
+#define polyvecl_sparse_mul_add DILITHIUM_NAMESPACE(polyvecl_sparse_mul_add)
+void polyvecl_sparse_mul_add(polyvecl *r, const poly_sparse *c, const polyvecl *v);
+
 #define polyvecl_chknorm DILITHIUM_NAMESPACE(polyvecl_chknorm)
 int polyvecl_chknorm(const polyvecl *v, int32_t B);
 
@@ -46,7 +52,8 @@ typedef struct {
 } polyveck;
 
 #define polyveck_uniform_eta DILITHIUM_NAMESPACE(polyveck_uniform_eta)
-void polyveck_uniform_eta(polyveck *v, const uint8_t seed[CRHBYTES], uint16_t nonce);
+void polyveck_uniform_eta(polyveck *v, const uint8_t seed[CRHBYTES], uint16_t nonce,
+                          const dilithium_symmetric *sym);
 
 #define polyveck_reduce DILITHIUM_NAMESPACE(polyveck_reduce)
 void polyveck_reduce(polyveck *v);
@@ -67,6 +74,11 @@ void polyveck_invntt_tomont(polyveck *v);
 #define polyveck_pointwise_poly_montgomery DILITHIUM_NAMESPACE(polyveck_pointwise_poly_montgomery)
 void polyveck_pointwise_poly_montgomery(polyveck *r, const poly *a, const polyveck *v);
 
+#define polyveck_sparse_mul DILITHIUM_NAMESPACE(polyveck_sparse_mul)
+void polyveck_sparse_mul(polyveck *r, const poly_sparse *c, const polyveck *v);
+#define polyveck_sparse_mul_sub DILITHIUM_NAMESPACE(polyveck_sparse_mul_sub)
+void polyveck_sparse_mul_sub(polyveck *r, const poly_sparse *c, const polyveck *v);
+
 #define polyveck_chknorm DILITHIUM_NAMESPACE(polyveck_chknorm)
 int polyveck_chknorm(const polyveck *v, int32_t B);
 
@@ -85,7 +97,8 @@ void polyveck_use_hint(polyveck *w, const polyveck *v, const polyveck *h);
 void polyveck_pack_w1(uint8_t r[K*POLYW1_PACKEDBYTES], const polyveck *w1);
 
 #define polyvec_matrix_expand DILITHIUM_NAMESPACE(polyvec_matrix_expand)
-void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES]);
+void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES],
+                           const dilithium_symmetric *sym);
 
 #define polyvec_matrix_pointwise_montgomery DILITHIUM_NAMESPACE(polyvec_matrix_pointwise_montgomery)
 void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], const polyvecl *v);
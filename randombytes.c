@@ -1,7 +1,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "randombytes.h"
+#include "iosha.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -16,10 +18,11 @@
 #else
 #include <unistd.h>
 #endif
+#include <pthread.h>
 #endif
 
 #ifdef _WIN32
-void randombytes(uint8_t *out, size_t outlen) {
+static void randombytes_os(uint8_t *out, size_t outlen) {
   HCRYPTPROV ctx;
   size_t len;
 
@@ -39,7 +42,7 @@ void randombytes(uint8_t *out, size_t outlen) {
     abort();
 }
 #elif defined(__linux__) && defined(SYS_getrandom)
-void randombytes(uint8_t *out, size_t outlen) {
+static void randombytes_os(uint8_t *out, size_t outlen) {
   ssize_t ret;
 
   while(outlen > 0) {
@@ -54,7 +57,7 @@ void randombytes(uint8_t *out, size_t outlen) {
   }
 }
 #else
-void randombytes(uint8_t *out, size_t outlen) {
+static void randombytes_os(uint8_t *out, size_t outlen) {
   static int fd = -1;
   ssize_t ret;
 
@@ -78,3 +81,144 @@ void randombytes(uint8_t *out, size_t outlen) {
   }
 }
 #endif
+
+#if RANDOMBYTES_POOL_BYTES == 0
+void randombytes(uint8_t *out, size_t outlen) {
+  randombytes_os(out, outlen);
+}
+
+void randombytes_clear(void) {
+}
+#else
+/* Per-thread fast-key-erasure DRBG on IOSHA (tag 0x05). Each refill turns
+   the key into a fresh key plus RANDOMBYTES_POOL_BYTES of output, so the
+   pool never holds anything that can reproduce bytes already handed out;
+   served bytes are wiped as they leave. The key absorbs 64 bytes from the
+   OS on first use, every RANDOMBYTES_RESEED_BYTES of output and after a
+   fork, and the pool of the forking thread is wiped in the child. */
+#if RANDOMBYTES_POOL_BYTES % 64
+#error "RANDOMBYTES_POOL_BYTES must be a multiple of the IOSHA rate (64)"
+#endif
+
+#define DRBG_TAG 0x05
+#define DRBG_KEYBYTES 64
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+typedef struct {
+  uint8_t key[DRBG_KEYBYTES];
+  uint8_t buf[RANDOMBYTES_POOL_BYTES];
+  size_t pos;           /* next unserved byte of buf */
+  size_t generated;     /* bytes served since the last reseed */
+  int seeded;
+} drbg_pool;
+
+static THREAD_LOCAL drbg_pool pool;
+
+static void wipe(void *p, size_t len) {
+  volatile uint8_t *v = (volatile uint8_t *)p;
+
+  while(len--)
+    *v++ = 0;
+}
+
+#ifndef _WIN32
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static void pool_atfork_child(void) {
+  /* Only the forking thread survives, so this is the only live pool */
+  wipe(&pool, sizeof(pool));
+}
+
+static void pool_register_atfork(void) {
+  if(pthread_atfork(NULL, NULL, pool_atfork_child))
+    abort();
+}
+#endif
+
+static void pool_refill(drbg_pool *p) {
+  uint8_t seed[DRBG_KEYBYTES];
+  iosha_ctx ctx;
+
+  iosha_init(&ctx, DRBG_TAG);
+  iosha_absorb(&ctx, p->key, DRBG_KEYBYTES);
+  if(!p->seeded || p->generated >= RANDOMBYTES_RESEED_BYTES) {
+#ifndef _WIN32
+    if(!p->seeded && pthread_once(&atfork_once, pool_register_atfork))
+      abort();
+#endif
+    randombytes_os(seed, DRBG_KEYBYTES);
+    iosha_absorb(&ctx, seed, DRBG_KEYBYTES);
+    wipe(seed, DRBG_KEYBYTES);
+    p->generated = 0;
+    p->seeded = 1;
+  }
+  iosha_finalize(&ctx);
+  iosha_squeezeblocks(p->key, DRBG_KEYBYTES/64, &ctx);
+  iosha_squeezeblocks(p->buf, RANDOMBYTES_POOL_BYTES/64, &ctx);
+  wipe(&ctx, sizeof(ctx));
+  p->pos = 0;
+}
+
+void randombytes(uint8_t *out, size_t outlen) {
+  drbg_pool *p = &pool;
+  size_t n;
+
+  if(!p->seeded)
+    p->pos = RANDOMBYTES_POOL_BYTES;
+
+  while(outlen > 0) {
+    if(p->pos == RANDOMBYTES_POOL_BYTES)
+      pool_refill(p);
+
+    n = RANDOMBYTES_POOL_BYTES - p->pos;
+    if(n > outlen)
+      n = outlen;
+    memcpy(out, p->buf + p->pos, n);
+    wipe(p->buf + p->pos, n);
+    p->pos += n;
+    p->generated += n;
+    out += n;
+    outlen -= n;
+  }
+}
+
+void randombytes_clear(void) {
+  wipe(&pool, sizeof(pool));
+}
+#endif
+
+static void randombytes_det_fill(void *state, uint8_t *out, size_t outlen) {
+  randombytes_det_state *det = (randombytes_det_state *)state;
+  size_t n;
+
+  while(outlen > 0) {
+    if(det->pos == sizeof(det->buf)) {
+      iosha_squeezeblocks(det->buf, 1, &det->xof);
+      det->pos = 0;
+    }
+
+    n = sizeof(det->buf) - det->pos;
+    if(n > outlen)
+      n = outlen;
+    memcpy(out, det->buf + det->pos, n);
+    det->pos += n;
+    out += n;
+    outlen -= n;
+  }
+}
+
+void randombytes_det_init(randombytes_rng *rng, randombytes_det_state *det,
+                          const uint8_t *seed, size_t seedlen) {
+  iosha_init(&det->xof, 0x06);
+  iosha_absorb(&det->xof, seed, seedlen);
+  iosha_finalize(&det->xof);
+  det->pos = sizeof(det->buf);
+
+  rng->fill = randombytes_det_fill;
+  rng->state = det;
+}
@@ -3,7 +3,41 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "iosha.h"
+
+/* randombytes is served from a per-thread IOSHA DRBG seeded by the OS.
+   RANDOMBYTES_POOL_BYTES is the output generated per refill (a multiple
+   of 64; 0 asks the OS on every call), RANDOMBYTES_RESEED_BYTES the
+   output after which the DRBG reseeds from the OS. */
+#ifndef RANDOMBYTES_POOL_BYTES
+#define RANDOMBYTES_POOL_BYTES 4096
+#endif
+#ifndef RANDOMBYTES_RESEED_BYTES
+#define RANDOMBYTES_RESEED_BYTES (1UL << 20)
+#endif
 
 void randombytes(uint8_t *out, size_t outlen);
 
+/* Wipe the calling thread's pool, e.g. before the thread exits */
+void randombytes_clear(void);
+
+/* Randomness callback for the context APIs; NULL there means
+   randombytes() */
+typedef struct {
+  void (*fill)(void *state, uint8_t *out, size_t outlen);
+  void *state;
+} randombytes_rng;
+
+/* Deterministic source: the IOSHA XOF (tag 0x06) of a seed, so that runs
+   from the same seed replay the same keys, rnd values and rejection
+   iterations. For testing and benchmarking only. */
+typedef struct {
+  iosha_ctx xof;
+  uint8_t buf[64];
+  unsigned int pos;
+} randombytes_det_state;
+
+void randombytes_det_init(randombytes_rng *rng, randombytes_det_state *det,
+                          const uint8_t *seed, size_t seedlen);
+
 #endif
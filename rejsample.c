@@ -0,0 +1,555 @@
+#include <stdint.h>
+#include "params.h"
+#include "rejsample.h"
+
+#ifdef DBENCH
+#include "test/cpucycles.h"
+extern const uint64_t timing_overhead;
+extern uint64_t *tsample;
+#define DBENCH_START() uint64_t time = cpucycles()
+#define DBENCH_STOP(t) t += cpucycles() - time - timing_overhead
+#else
+#define DBENCH_START()
+#define DBENCH_STOP(t)
+#endif
+
+/* The AVX2 samplers are compiled with a target attribute and picked at
+   run time, so the default build flags stay portable. */
+#if !defined(REJSAMPLE_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(_M_X64))
+#define REJSAMPLE_AVX2
+#include <immintrin.h>
+#define REJSAMPLE_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+/*************************************************
+* Name:        rej_uniform_ref
+*
+* Description: Sample uniformly random coefficients in [0, Q-1] by
+*              performing rejection sampling on array of random bytes.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*
+* Returns number of sampled coefficients. Can be smaller than len if not enough
+* random bytes were given.
+**************************************************/
+unsigned int rej_uniform_ref(int32_t *a,
+                             unsigned int len,
+                             const uint8_t *buf,
+                             unsigned int buflen)
+{
+  unsigned int ctr, pos;
+  uint32_t t;
+
+  ctr = pos = 0;
+  while(ctr < len && pos + 3 <= buflen) {
+    t  = buf[pos++];
+    t |= (uint32_t)buf[pos++] << 8;
+    t |= (uint32_t)buf[pos++] << 16;
+    t &= 0x7FFFFF;
+
+    if(t < Q)
+      a[ctr++] = t;
+  }
+
+  return ctr;
+}
+
+
+/*************************************************
+* Name:        rej_eta_ref
+*
+* Description: Sample uniformly random coefficients in [-ETA, ETA] by
+*              performing rejection sampling on array of random bytes.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*
+* Returns number of sampled coefficients. Can be smaller than len if not enough
+* random bytes were given.
+**************************************************/
+unsigned int rej_eta_ref(int32_t *a,
+                         unsigned int len,
+                         const uint8_t *buf,
+                         unsigned int buflen)
+{
+  unsigned int ctr, pos;
+  uint32_t t0, t1;
+
+  ctr = pos = 0;
+  while(ctr < len && pos < buflen) {
+    t0 = buf[pos] & 0x0F;
+    t1 = buf[pos++] >> 4;
+
+#if ETA == 2
+    if(t0 < 15) {
+      t0 = t0 - (205*t0 >> 10)*5;
+      a[ctr++] = 2 - t0;
+    }
+    if(t1 < 15 && ctr < len) {
+      t1 = t1 - (205*t1 >> 10)*5;
+      a[ctr++] = 2 - t1;
+    }
+#elif ETA == 4
+    if(t0 < 9)
+      a[ctr++] = 4 - t0;
+    if(t1 < 9 && ctr < len)
+      a[ctr++] = 4 - t1;
+#endif
+  }
+
+  return ctr;
+}
+
+#ifdef REJSAMPLE_AVX2
+/* Row m lists the set bits of m in increasing order: the permutation that
+   moves the accepted lanes of an 8-lane vector to the front */
+static const uint8_t idxlut[256][8] = {
+  {0, 0, 0, 0, 0, 0, 0, 0},
+  {0, 0, 0, 0, 0, 0, 0, 0},
+  {1, 0, 0, 0, 0, 0, 0, 0},
+  {0, 1, 0, 0, 0, 0, 0, 0},
+  {2, 0, 0, 0, 0, 0, 0, 0},
+  {0, 2, 0, 0, 0, 0, 0, 0},
+  {1, 2, 0, 0, 0, 0, 0, 0},
+  {0, 1, 2, 0, 0, 0, 0, 0},
+  {3, 0, 0, 0, 0, 0, 0, 0},
+  {0, 3, 0, 0, 0, 0, 0, 0},
+  {1, 3, 0, 0, 0, 0, 0, 0},
+  {0, 1, 3, 0, 0, 0, 0, 0},
+  {2, 3, 0, 0, 0, 0, 0, 0},
+  {0, 2, 3, 0, 0, 0, 0, 0},
+  {1, 2, 3, 0, 0, 0, 0, 0},
+  {0, 1, 2, 3, 0, 0, 0, 0},
+  {4, 0, 0, 0, 0, 0, 0, 0},
+  {0, 4, 0, 0, 0, 0, 0, 0},
+  {1, 4, 0, 0, 0, 0, 0, 0},
+  {0, 1, 4, 0, 0, 0, 0, 0},
+  {2, 4, 0, 0, 0, 0, 0, 0},
+  {0, 2, 4, 0, 0, 0, 0, 0},
+  {1, 2, 4, 0, 0, 0, 0, 0},
+  {0, 1, 2, 4, 0, 0, 0, 0},
+  {3, 4, 0, 0, 0, 0, 0, 0},
+  {0, 3, 4, 0, 0, 0, 0, 0},
+  {1, 3, 4, 0, 0, 0, 0, 0},
+  {0, 1, 3, 4, 0, 0, 0, 0},
+  {2, 3, 4, 0, 0, 0, 0, 0},
+  {0, 2, 3, 4, 0, 0, 0, 0},
+  {1, 2, 3, 4, 0, 0, 0, 0},
+  {0, 1, 2, 3, 4, 0, 0, 0},
+  {5, 0, 0, 0, 0, 0, 0, 0},
+  {0, 5, 0, 0, 0, 0, 0, 0},
+  {1, 5, 0, 0, 0, 0, 0, 0},
+  {0, 1, 5, 0, 0, 0, 0, 0},
+  {2, 5, 0, 0, 0, 0, 0, 0},
+  {0, 2, 5, 0, 0, 0, 0, 0},
+  {1, 2, 5, 0, 0, 0, 0, 0},
+  {0, 1, 2, 5, 0, 0, 0, 0},
+  {3, 5, 0, 0, 0, 0, 0, 0},
+  {0, 3, 5, 0, 0, 0, 0, 0},
+  {1, 3, 5, 0, 0, 0, 0, 0},
+  {0, 1, 3, 5, 0, 0, 0, 0},
+  {2, 3, 5, 0, 0, 0, 0, 0},
+  {0, 2, 3, 5, 0, 0, 0, 0},
+  {1, 2, 3, 5, 0, 0, 0, 0},
+  {0, 1, 2, 3, 5, 0, 0, 0},
+  {4, 5, 0, 0, 0, 0, 0, 0},
+  {0, 4, 5, 0, 0, 0, 0, 0},
+  {1, 4, 5, 0, 0, 0, 0, 0},
+  {0, 1, 4, 5, 0, 0, 0, 0},
+  {2, 4, 5, 0, 0, 0, 0, 0},
+  {0, 2, 4, 5, 0, 0, 0, 0},
+  {1, 2, 4, 5, 0, 0, 0, 0},
+  {0, 1, 2, 4, 5, 0, 0, 0},
+  {3, 4, 5, 0, 0, 0, 0, 0},
+  {0, 3, 4, 5, 0, 0, 0, 0},
+  {1, 3, 4, 5, 0, 0, 0, 0},
+  {0, 1, 3, 4, 5, 0, 0, 0},
+  {2, 3, 4, 5, 0, 0, 0, 0},
+  {0, 2, 3, 4, 5, 0, 0, 0},
+  {1, 2, 3, 4, 5, 0, 0, 0},
+  {0, 1, 2, 3, 4, 5, 0, 0},
+  {6, 0, 0, 0, 0, 0, 0, 0},
+  {0, 6, 0, 0, 0, 0, 0, 0},
+  {1, 6, 0, 0, 0, 0, 0, 0},
+  {0, 1, 6, 0, 0, 0, 0, 0},
+  {2, 6, 0, 0, 0, 0, 0, 0},
+  {0, 2, 6, 0, 0, 0, 0, 0},
+  {1, 2, 6, 0, 0, 0, 0, 0},
+  {0, 1, 2, 6, 0, 0, 0, 0},
+  {3, 6, 0, 0, 0, 0, 0, 0},
+  {0, 3, 6, 0, 0, 0, 0, 0},
+  {1, 3, 6, 0, 0, 0, 0, 0},
+  {0, 1, 3, 6, 0, 0, 0, 0},
+  {2, 3, 6, 0, 0, 0, 0, 0},
+  {0, 2, 3, 6, 0, 0, 0, 0},
+  {1, 2, 3, 6, 0, 0, 0, 0},
+  {0, 1, 2, 3, 6, 0, 0, 0},
+  {4, 6, 0, 0, 0, 0, 0, 0},
+  {0, 4, 6, 0, 0, 0, 0, 0},
+  {1, 4, 6, 0, 0, 0, 0, 0},
+  {0, 1, 4, 6, 0, 0, 0, 0},
+  {2, 4, 6, 0, 0, 0, 0, 0},
+  {0, 2, 4, 6, 0, 0, 0, 0},
+  {1, 2, 4, 6, 0, 0, 0, 0},
+  {0, 1, 2, 4, 6, 0, 0, 0},
+  {3, 4, 6, 0, 0, 0, 0, 0},
+  {0, 3, 4, 6, 0, 0, 0, 0},
+  {1, 3, 4, 6, 0, 0, 0, 0},
+  {0, 1, 3, 4, 6, 0, 0, 0},
+  {2, 3, 4, 6, 0, 0, 0, 0},
+  {0, 2, 3, 4, 6, 0, 0, 0},
+  {1, 2, 3, 4, 6, 0, 0, 0},
+  {0, 1, 2, 3, 4, 6, 0, 0},
+  {5, 6, 0, 0, 0, 0, 0, 0},
+  {0, 5, 6, 0, 0, 0, 0, 0},
+  {1, 5, 6, 0, 0, 0, 0, 0},
+  {0, 1, 5, 6, 0, 0, 0, 0},
+  {2, 5, 6, 0, 0, 0, 0, 0},
+  {0, 2, 5, 6, 0, 0, 0, 0},
+  {1, 2, 5, 6, 0, 0, 0, 0},
+  {0, 1, 2, 5, 6, 0, 0, 0},
+  {3, 5, 6, 0, 0, 0, 0, 0},
+  {0, 3, 5, 6, 0, 0, 0, 0},
+  {1, 3, 5, 6, 0, 0, 0, 0},
+  {0, 1, 3, 5, 6, 0, 0, 0},
+  {2, 3, 5, 6, 0, 0, 0, 0},
+  {0, 2, 3, 5, 6, 0, 0, 0},
+  {1, 2, 3, 5, 6, 0, 0, 0},
+  {0, 1, 2, 3, 5, 6, 0, 0},
+  {4, 5, 6, 0, 0, 0, 0, 0},
+  {0, 4, 5, 6, 0, 0, 0, 0},
+  {1, 4, 5, 6, 0, 0, 0, 0},
+  {0, 1, 4, 5, 6, 0, 0, 0},
+  {2, 4, 5, 6, 0, 0, 0, 0},
+  {0, 2, 4, 5, 6, 0, 0, 0},
+  {1, 2, 4, 5, 6, 0, 0, 0},
+  {0, 1, 2, 4, 5, 6, 0, 0},
+  {3, 4, 5, 6, 0, 0, 0, 0},
+  {0, 3, 4, 5, 6, 0, 0, 0},
+  {1, 3, 4, 5, 6, 0, 0, 0},
+  {0, 1, 3, 4, 5, 6, 0, 0},
+  {2, 3, 4, 5, 6, 0, 0, 0},
+  {0, 2, 3, 4, 5, 6, 0, 0},
+  {1, 2, 3, 4, 5, 6, 0, 0},
+  {0, 1, 2, 3, 4, 5, 6, 0},
+  {7, 0, 0, 0, 0, 0, 0, 0},
+  {0, 7, 0, 0, 0, 0, 0, 0},
+  {1, 7, 0, 0, 0, 0, 0, 0},
+  {0, 1, 7, 0, 0, 0, 0, 0},
+  {2, 7, 0, 0, 0, 0, 0, 0},
+  {0, 2, 7, 0, 0, 0, 0, 0},
+  {1, 2, 7, 0, 0, 0, 0, 0},
+  {0, 1, 2, 7, 0, 0, 0, 0},
+  {3, 7, 0, 0, 0, 0, 0, 0},
+  {0, 3, 7, 0, 0, 0, 0, 0},
+  {1, 3, 7, 0, 0, 0, 0, 0},
+  {0, 1, 3, 7, 0, 0, 0, 0},
+  {2, 3, 7, 0, 0, 0, 0, 0},
+  {0, 2, 3, 7, 0, 0, 0, 0},
+  {1, 2, 3, 7, 0, 0, 0, 0},
+  {0, 1, 2, 3, 7, 0, 0, 0},
+  {4, 7, 0, 0, 0, 0, 0, 0},
+  {0, 4, 7, 0, 0, 0, 0, 0},
+  {1, 4, 7, 0, 0, 0, 0, 0},
+  {0, 1, 4, 7, 0, 0, 0, 0},
+  {2, 4, 7, 0, 0, 0, 0, 0},
+  {0, 2, 4, 7, 0, 0, 0, 0},
+  {1, 2, 4, 7, 0, 0, 0, 0},
+  {0, 1, 2, 4, 7, 0, 0, 0},
+  {3, 4, 7, 0, 0, 0, 0, 0},
+  {0, 3, 4, 7, 0, 0, 0, 0},
+  {1, 3, 4, 7, 0, 0, 0, 0},
+  {0, 1, 3, 4, 7, 0, 0, 0},
+  {2, 3, 4, 7, 0, 0, 0, 0},
+  {0, 2, 3, 4, 7, 0, 0, 0},
+  {1, 2, 3, 4, 7, 0, 0, 0},
+  {0, 1, 2, 3, 4, 7, 0, 0},
+  {5, 7, 0, 0, 0, 0, 0, 0},
+  {0, 5, 7, 0, 0, 0, 0, 0},
+  {1, 5, 7, 0, 0, 0, 0, 0},
+  {0, 1, 5, 7, 0, 0, 0, 0},
+  {2, 5, 7, 0, 0, 0, 0, 0},
+  {0, 2, 5, 7, 0, 0, 0, 0},
+  {1, 2, 5, 7, 0, 0, 0, 0},
+  {0, 1, 2, 5, 7, 0, 0, 0},
+  {3, 5, 7, 0, 0, 0, 0, 0},
+  {0, 3, 5, 7, 0, 0, 0, 0},
+  {1, 3, 5, 7, 0, 0, 0, 0},
+  {0, 1, 3, 5, 7, 0, 0, 0},
+  {2, 3, 5, 7, 0, 0, 0, 0},
+  {0, 2, 3, 5, 7, 0, 0, 0},
+  {1, 2, 3, 5, 7, 0, 0, 0},
+  {0, 1, 2, 3, 5, 7, 0, 0},
+  {4, 5, 7, 0, 0, 0, 0, 0},
+  {0, 4, 5, 7, 0, 0, 0, 0},
+  {1, 4, 5, 7, 0, 0, 0, 0},
+  {0, 1, 4, 5, 7, 0, 0, 0},
+  {2, 4, 5, 7, 0, 0, 0, 0},
+  {0, 2, 4, 5, 7, 0, 0, 0},
+  {1, 2, 4, 5, 7, 0, 0, 0},
+  {0, 1, 2, 4, 5, 7, 0, 0},
+  {3, 4, 5, 7, 0, 0, 0, 0},
+  {0, 3, 4, 5, 7, 0, 0, 0},
+  {1, 3, 4, 5, 7, 0, 0, 0},
+  {0, 1, 3, 4, 5, 7, 0, 0},
+  {2, 3, 4, 5, 7, 0, 0, 0},
+  {0, 2, 3, 4, 5, 7, 0, 0},
+  {1, 2, 3, 4, 5, 7, 0, 0},
+  {0, 1, 2, 3, 4, 5, 7, 0},
+  {6, 7, 0, 0, 0, 0, 0, 0},
+  {0, 6, 7, 0, 0, 0, 0, 0},
+  {1, 6, 7, 0, 0, 0, 0, 0},
+  {0, 1, 6, 7, 0, 0, 0, 0},
+  {2, 6, 7, 0, 0, 0, 0, 0},
+  {0, 2, 6, 7, 0, 0, 0, 0},
+  {1, 2, 6, 7, 0, 0, 0, 0},
+  {0, 1, 2, 6, 7, 0, 0, 0},
+  {3, 6, 7, 0, 0, 0, 0, 0},
+  {0, 3, 6, 7, 0, 0, 0, 0},
+  {1, 3, 6, 7, 0, 0, 0, 0},
+  {0, 1, 3, 6, 7, 0, 0, 0},
+  {2, 3, 6, 7, 0, 0, 0, 0},
+  {0, 2, 3, 6, 7, 0, 0, 0},
+  {1, 2, 3, 6, 7, 0, 0, 0},
+  {0, 1, 2, 3, 6, 7, 0, 0},
+  {4, 6, 7, 0, 0, 0, 0, 0},
+  {0, 4, 6, 7, 0, 0, 0, 0},
+  {1, 4, 6, 7, 0, 0, 0, 0},
+  {0, 1, 4, 6, 7, 0, 0, 0},
+  {2, 4, 6, 7, 0, 0, 0, 0},
+  {0, 2, 4, 6, 7, 0, 0, 0},
+  {1, 2, 4, 6, 7, 0, 0, 0},
+  {0, 1, 2, 4, 6, 7, 0, 0},
+  {3, 4, 6, 7, 0, 0, 0, 0},
+  {0, 3, 4, 6, 7, 0, 0, 0},
+  {1, 3, 4, 6, 7, 0, 0, 0},
+  {0, 1, 3, 4, 6, 7, 0, 0},
+  {2, 3, 4, 6, 7, 0, 0, 0},
+  {0, 2, 3, 4, 6, 7, 0, 0},
+  {1, 2, 3, 4, 6, 7, 0, 0},
+  {0, 1, 2, 3, 4, 6, 7, 0},
+  {5, 6, 7, 0, 0, 0, 0, 0},
+  {0, 5, 6, 7, 0, 0, 0, 0},
+  {1, 5, 6, 7, 0, 0, 0, 0},
+  {0, 1, 5, 6, 7, 0, 0, 0},
+  {2, 5, 6, 7, 0, 0, 0, 0},
+  {0, 2, 5, 6, 7, 0, 0, 0},
+  {1, 2, 5, 6, 7, 0, 0, 0},
+  {0, 1, 2, 5, 6, 7, 0, 0},
+  {3, 5, 6, 7, 0, 0, 0, 0},
+  {0, 3, 5, 6, 7, 0, 0, 0},
+  {1, 3, 5, 6, 7, 0, 0, 0},
+  {0, 1, 3, 5, 6, 7, 0, 0},
+  {2, 3, 5, 6, 7, 0, 0, 0},
+  {0, 2, 3, 5, 6, 7, 0, 0},
+  {1, 2, 3, 5, 6, 7, 0, 0},
+  {0, 1, 2, 3, 5, 6, 7, 0},
+  {4, 5, 6, 7, 0, 0, 0, 0},
+  {0, 4, 5, 6, 7, 0, 0, 0},
+  {1, 4, 5, 6, 7, 0, 0, 0},
+  {0, 1, 4, 5, 6, 7, 0, 0},
+  {2, 4, 5, 6, 7, 0, 0, 0},
+  {0, 2, 4, 5, 6, 7, 0, 0},
+  {1, 2, 4, 5, 6, 7, 0, 0},
+  {0, 1, 2, 4, 5, 6, 7, 0},
+  {3, 4, 5, 6, 7, 0, 0, 0},
+  {0, 3, 4, 5, 6, 7, 0, 0},
+  {1, 3, 4, 5, 6, 7, 0, 0},
+  {0, 1, 3, 4, 5, 6, 7, 0},
+  {2, 3, 4, 5, 6, 7, 0, 0},
+  {0, 2, 3, 4, 5, 6, 7, 0},
+  {1, 2, 3, 4, 5, 6, 7, 0},
+  {0, 1, 2, 3, 4, 5, 6, 7}
+};
+
+/*************************************************
+* Name:        rej_uniform_avx2
+*
+* Description: rej_uniform_ref on 24 bytes per step: the bytes are spread
+*              into eight 23-bit candidates, compared against Q, and the
+*              accepted ones packed to the front with a table permutation.
+*              Stops once fewer than 8 coefficients are wanted or fewer
+*              than 24 bytes are left; the caller finishes with the
+*              scalar loop, so the output is identical.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*              - unsigned int *pos: pointer to number of bytes consumed
+*
+* Returns number of sampled coefficients.
+**************************************************/
+REJSAMPLE_TARGET_AVX2
+static unsigned int rej_uniform_avx2(int32_t *a,
+                                     unsigned int len,
+                                     const uint8_t *buf,
+                                     unsigned int buflen,
+                                     unsigned int *pos)
+{
+  unsigned int ctr, good;
+  __m128i lo, hi;
+  __m256i d, pi;
+  const __m256i bound = _mm256_set1_epi32(Q);
+  const __m256i mask = _mm256_set1_epi32(0x7FFFFF);
+  const __m256i idx8 = _mm256_set_epi8(-1,15,14,13,-1,12,11,10,
+                                       -1, 9, 8, 7,-1, 6, 5, 4,
+                                       -1,11,10, 9,-1, 8, 7, 6,
+                                       -1, 5, 4, 3,-1, 2, 1, 0);
+
+  ctr = 0;
+  while(ctr + 8 <= len && *pos + 24 <= buflen) {
+    /* Bytes 0..15 into the low half, 8..23 into the high half */
+    lo = _mm_loadu_si128((const __m128i *)&buf[*pos]);
+    hi = _mm_loadl_epi64((const __m128i *)&buf[*pos + 16]);
+    d = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    d = _mm256_permute4x64_epi64(d, 0x94);
+    d = _mm256_shuffle_epi8(d, idx8);
+    d = _mm256_and_si256(d, mask);
+    *pos += 24;
+
+    good = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(bound, d)));
+    pi = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)idxlut[good]));
+    d = _mm256_permutevar8x32_epi32(d, pi);
+
+    _mm256_storeu_si256((__m256i *)&a[ctr], d);
+    ctr += _mm_popcnt_u32(good);
+  }
+
+  return ctr;
+}
+
+/*************************************************
+* Name:        rej_eta_avx2
+*
+* Description: rej_eta_ref on 8 bytes per step: the 16 nibbles are split
+*              out in stream order, mapped to [-ETA, ETA] with a byte
+*              shuffle and the accepted ones packed to the front eight at
+*              a time with the same table as rej_uniform_avx2. Stops once
+*              fewer than 16 coefficients are wanted or fewer than 8 bytes
+*              are left; the caller finishes with the scalar loop.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*              - unsigned int *pos: pointer to number of bytes consumed
+*
+* Returns number of sampled coefficients.
+**************************************************/
+REJSAMPLE_TARGET_AVX2
+static unsigned int rej_eta_avx2(int32_t *a,
+                                 unsigned int len,
+                                 const uint8_t *buf,
+                                 unsigned int buflen,
+                                 unsigned int *pos)
+{
+  unsigned int ctr, good;
+  __m128i f, t;
+#if ETA == 2
+  /* t -> 2 - (t mod 5) for the accepted t < 15 */
+  const __m128i bound = _mm_set1_epi8(15);
+  const __m128i lut = _mm_setr_epi8(2, 1, 0,-1,-2, 2, 1, 0,
+                                   -1,-2, 2, 1, 0,-1,-2, 0);
+#elif ETA == 4
+  /* t -> 4 - t for the accepted t < 9 */
+  const __m128i bound = _mm_set1_epi8(9);
+  const __m128i lut = _mm_setr_epi8(4, 3, 2, 1, 0,-1,-2,-3,
+                                   -4, 0, 0, 0, 0, 0, 0, 0);
+#endif
+  const __m128i mask = _mm_set1_epi8(0x0F);
+
+  ctr = 0;
+  while(ctr + 16 <= len && *pos + 8 <= buflen) {
+    /* Low nibble before high nibble, byte by byte */
+    f = _mm_loadl_epi64((const __m128i *)&buf[*pos]);
+    f = _mm_unpacklo_epi8(_mm_and_si128(f, mask),
+                          _mm_and_si128(_mm_srli_epi16(f, 4), mask));
+    *pos += 8;
+
+    good = _mm_movemask_epi8(_mm_cmplt_epi8(f, bound));
+    f = _mm_shuffle_epi8(lut, f);
+
+    t = _mm_shuffle_epi8(f, _mm_loadl_epi64((const __m128i *)idxlut[good & 0xFF]));
+    _mm256_storeu_si256((__m256i *)&a[ctr], _mm256_cvtepi8_epi32(t));
+    ctr += _mm_popcnt_u32(good & 0xFF);
+
+    f = _mm_srli_si128(f, 8);
+    t = _mm_shuffle_epi8(f, _mm_loadl_epi64((const __m128i *)idxlut[good >> 8]));
+    _mm256_storeu_si256((__m256i *)&a[ctr], _mm256_cvtepi8_epi32(t));
+    ctr += _mm_popcnt_u32(good >> 8);
+  }
+
+  return ctr;
+}
+#endif
+
+/*************************************************
+* Name:        rej_uniform
+*
+* Description: Same as rej_uniform_ref; takes 24 bytes per step with AVX2
+*              when the CPU has it.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*
+* Returns number of sampled coefficients. Can be smaller than len if not enough
+* random bytes were given.
+**************************************************/
+unsigned int rej_uniform(int32_t *a,
+                         unsigned int len,
+                         const uint8_t *buf,
+                         unsigned int buflen)
+{
+  unsigned int ctr = 0, pos = 0;
+  DBENCH_START();
+
+#ifdef REJSAMPLE_AVX2
+  if(__builtin_cpu_supports("avx2"))
+    ctr = rej_uniform_avx2(a, len, buf, buflen, &pos);
+#endif
+
+  ctr += rej_uniform_ref(a + ctr, len - ctr, buf + pos, buflen - pos);
+  DBENCH_STOP(*tsample);
+  return ctr;
+}
+
+/*************************************************
+* Name:        rej_eta
+*
+* Description: Same as rej_eta_ref; takes 8 bytes per step with AVX2 when
+*              the CPU has it.
+*
+* Arguments:   - int32_t *a: pointer to output array (allocated)
+*              - unsigned int len: number of coefficients to be sampled
+*              - const uint8_t *buf: array of random bytes
+*              - unsigned int buflen: length of array of random bytes
+*
+* Returns number of sampled coefficients. Can be smaller than len if not enough
+* random bytes were given.
+**************************************************/
+unsigned int rej_eta(int32_t *a,
+                     unsigned int len,
+                     const uint8_t *buf,
+                     unsigned int buflen)
+{
+  unsigned int ctr = 0, pos = 0;
+  DBENCH_START();
+
+#ifdef REJSAMPLE_AVX2
+  if(__builtin_cpu_supports("avx2"))
+    ctr = rej_eta_avx2(a, len, buf, buflen, &pos);
+#endif
+
+  ctr += rej_eta_ref(a + ctr, len - ctr, buf + pos, buflen - pos);
+  DBENCH_STOP(*tsample);
+  return ctr;
+}
@@ -0,0 +1,31 @@
+#ifndef REJSAMPLE_H
+#define REJSAMPLE_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define rej_uniform_ref DILITHIUM_NAMESPACE(rej_uniform_ref)
+unsigned int rej_uniform_ref(int32_t *a,
+                             unsigned int len,
+                             const uint8_t *buf,
+                             unsigned int buflen);
+
+#define rej_uniform DILITHIUM_NAMESPACE(rej_uniform)
+unsigned int rej_uniform(int32_t *a,
+                         unsigned int len,
+                         const uint8_t *buf,
+                         unsigned int buflen);
+
+#define rej_eta_ref DILITHIUM_NAMESPACE(rej_eta_ref)
+unsigned int rej_eta_ref(int32_t *a,
+                         unsigned int len,
+                         const uint8_t *buf,
+                         unsigned int buflen);
+
+#define rej_eta DILITHIUM_NAMESPACE(rej_eta)
+unsigned int rej_eta(int32_t *a,
+                     unsigned int len,
+                     const uint8_t *buf,
+                     unsigned int buflen);
+
+#endif
@@ -1,18 +1,87 @@
 #include <stdint.h>
+#include <string.h>
 #include "params.h"
 #include "sign.h"
 #include "packing.h"
 #include "polyvec.h"
 #include "poly.h"
+#include "matcache.h"
 #include "randombytes.h"
-#include "symmetric.h"    // brings iosha.h indirectly
-#include "fips202.h"      // for keccak_state typedef (unused now)
+#include "symmetric.h"
+
+/* NULL selects the build's default backend */
+static const dilithium_symmetric *backend(const dilithium_symmetric *sym)
+{
+  return sym ? sym : &dilithium_symmetric_default;
+}
+
+/* Fill out from rng, or from randombytes() when rng is NULL */
+static void rng_fill(const randombytes_rng *rng, uint8_t *out, size_t outlen)
+{
+  if(rng)
+    rng->fill(rng->state, out, outlen);
+  else
+    randombytes(out, outlen);
+}
+
+/* One-shot CRH */
+static void crh(uint8_t *out, size_t outlen,
+                const uint8_t *in, size_t inlen,
+                const dilithium_symmetric *sym)
+{
+  crh_state st;
+
+  sym->crh_init(&st);
+  sym->crh_absorb(&st, in, inlen);
+  sym->crh_squeeze(&st, out, outlen);
+}
+
+/*************************************************
+* Name:        absorb_message
+*
+* Description: Absorbs the message into the mu sponge; with
+*              DILITHIUM_TREE_MU the message is represented by the root of
+*              the parallel IOSHA tree hash (IOSHA for either backend).
+**************************************************/
+static void absorb_message(crh_state *ctx, const uint8_t *m, size_t mlen,
+                           const dilithium_symmetric *sym)
+{
+#ifdef DILITHIUM_TREE_MU
+  uint8_t root[CRHBYTES];
+
+  iosha_tree_bytes(m, mlen, root, CRHBYTES);
+  sym->crh_absorb(ctx, root, CRHBYTES);
+#else
+  sym->crh_absorb(ctx, m, mlen);
+#endif
+}
 
 /*************************************************
 * Name:        crypto_sign_keypair
 * Description: Generates public and private key.
 **************************************************/
 int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
+  return crypto_sign_keypair_sym(pk, sk, NULL);
+}
+
+/*************************************************
+* Name:        crypto_sign_keypair_sym
+* Description: Generates public and private key with the given hash
+*              backend (NULL for the default).
+**************************************************/
+int crypto_sign_keypair_sym(uint8_t *pk, uint8_t *sk,
+                            const dilithium_symmetric *sym) {
+  return crypto_sign_keypair_rng(pk, sk, sym, NULL);
+}
+
+/*************************************************
+* Name:        crypto_sign_keypair_rng
+* Description: Generates public and private key with the given hash
+*              backend and randomness source (NULL for the defaults).
+**************************************************/
+int crypto_sign_keypair_rng(uint8_t *pk, uint8_t *sk,
+                            const dilithium_symmetric *sym,
+                            const randombytes_rng *rng) {
   uint8_t seedbuf[2*SEEDBYTES + CRHBYTES];
   uint8_t tr[TRBYTES];
   const uint8_t *rho, *rhoprime, *key;
@@ -21,24 +90,23 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
   polyveck s2, t1, t0;
 
   /* Get randomness for rho, rhoprime and key */
-  randombytes(seedbuf, SEEDBYTES);
+  rng_fill(rng, seedbuf, SEEDBYTES);
   seedbuf[SEEDBYTES+0] = K;
   seedbuf[SEEDBYTES+1] = L;
 
-  /* --- Replace shake256 one-shot with iosha_crh_bytes --- */
-  iosha_crh_bytes(seedbuf, 2*SEEDBYTES + CRHBYTES,
-                  seedbuf, SEEDBYTES+2);
+  sym = backend(sym);
+  crh(seedbuf, 2*SEEDBYTES + CRHBYTES, seedbuf, SEEDBYTES+2, sym);
 
   rho      = seedbuf;
   rhoprime = rho + SEEDBYTES;
   key      = rhoprime + CRHBYTES;
 
   /* Expand matrix */
-  polyvec_matrix_expand(mat, rho);
+  polyvec_matrix_expand(mat, rho, sym);
 
   /* Sample short vectors s1 and s2 */
-  polyvecl_uniform_eta(&s1, rhoprime, 0);
-  polyveck_uniform_eta(&s2, rhoprime, L);
+  polyvecl_uniform_eta(&s1, rhoprime, 0, sym);
+  polyveck_uniform_eta(&s2, rhoprime, L, sym);
 
   /* Matrix-vector multiplication */
   s1hat = s1;
@@ -55,9 +123,8 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
   polyveck_power2round(&t1, &t0, &t1);
   pack_pk(pk, rho, &t1);
 
-  /* --- Compute H(rho, t1) via IOSHA-v2 CRH --- */
-  iosha_crh_bytes(pk, CRYPTO_PUBLICKEYBYTES,
-                  tr, TRBYTES);
+  /* Compute H(rho, t1) */
+  crh(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES, sym);
 
   /* Write secret key */
   pack_sk(sk, rho, tr, key, &t0, &s1, &s2);
@@ -65,6 +132,45 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
   return 0;
 }
 
+/*************************************************
+* Name:        crypto_sign_signing_key_init
+*
+* Description: Unpacks a secret key into a signing context and precomputes
+*              everything that does not depend on the message: the matrix
+*              A and the CRH prefix states for mu (tr absorbed) and
+*              rhoprime (key absorbed). s1, s2 and t0 stay in the normal
+*              domain for the sparse challenge products.
+*              Signatures then go straight to the rejection loop.
+*
+* Arguments:   - dilithium_signing_key *ssk: pointer to output context
+*              - const uint8_t *sk: pointer to bit-packed secret key
+*              - const dilithium_symmetric *sym: hash backend the key was
+*                generated with (NULL for the default)
+*              - const randombytes_rng *rng: source of rnd (NULL for
+*                randombytes())
+**************************************************/
+void crypto_sign_signing_key_init(dilithium_signing_key *ssk,
+                                  const uint8_t *sk,
+                                  const dilithium_symmetric *sym,
+                                  const randombytes_rng *rng)
+{
+  uint8_t rho[SEEDBYTES];
+  uint8_t tr[TRBYTES];
+  uint8_t key[SEEDBYTES];
+
+  ssk->sym = sym = backend(sym);
+  ssk->rng = rng;
+  unpack_sk(rho, tr, key, &ssk->t0, &ssk->s1, &ssk->s2, sk);
+
+  polyvec_matrix_expand(ssk->mat, rho, sym);
+
+  sym->crh_init(&ssk->mu_prefix);
+  sym->crh_absorb(&ssk->mu_prefix, tr, TRBYTES);
+
+  sym->crh_init(&ssk->rhoprime_prefix);
+  sym->crh_absorb(&ssk->rhoprime_prefix, key, SEEDBYTES);
+}
+
 /*************************************************
 * Name:        crypto_sign_signature_internal
 * Description: Computes signature. Internal API.
@@ -78,51 +184,48 @@ int crypto_sign_signature_internal(uint8_t *sig,
                                    const uint8_t rnd[RNDBYTES],
                                    const uint8_t *sk)
 {
-  unsigned int n;
-  uint8_t seedbuf[2*SEEDBYTES + TRBYTES + 2*CRHBYTES];
-  uint8_t *rho, *tr, *key, *mu, *rhoprime;
+  dilithium_signing_key ssk;
+
+  crypto_sign_signing_key_init(&ssk, sk, NULL, NULL);
+  return crypto_sign_signature_key_internal(sig, siglen, m, mlen, pre, prelen,
+                                            rnd, &ssk);
+}
+
+/*************************************************
+* Name:        sign_mu
+*
+* Description: Computes signature for the message representative mu.
+**************************************************/
+static int sign_mu(uint8_t *sig,
+                   size_t *siglen,
+                   const uint8_t mu[CRHBYTES],
+                   const uint8_t rnd[RNDBYTES],
+                   const dilithium_signing_key *ssk)
+{
+  unsigned int i, n;
+  uint8_t rhoprime[CRHBYTES];
   uint16_t nonce = 0;
-  polyvecl mat[K], s1, y, z;
-  polyveck t0, s2, w1, w0, h;
+  polyvecl y, z;
+  polyveck w1, w0, h;
   poly cp;
-  iosha_ctx ctx;
+  poly_sparse c;
+  crh_state ctx;
+  const dilithium_symmetric *sym = ssk->sym;
 
-  /* Unpack secret key */
-  rho      = seedbuf;
-  tr       = rho + SEEDBYTES;
-  key      = tr  + TRBYTES;
-  mu       = key + SEEDBYTES;
-  rhoprime = mu  + CRHBYTES;
-  unpack_sk(rho, tr, key, &t0, &s1, &s2, sk);
-
-  /* --- mu = CRH(tr ∥ pre ∥ m) via IOSHA-v2 --- */
-  iosha_init(&ctx, 0x02);
-  iosha_absorb(&ctx, tr, TRBYTES);
-  iosha_absorb(&ctx, pre, prelen);
-  iosha_absorb(&ctx, m, mlen);
-  iosha_squeeze(&ctx, mu, CRHBYTES);
-
-  /* --- rhoprime = CRH(key ∥ rnd ∥ mu) via IOSHA-v2 --- */
-  iosha_init(&ctx, 0x02);
-  iosha_absorb(&ctx, key, SEEDBYTES);
-  iosha_absorb(&ctx, rnd, RNDBYTES);
-  iosha_absorb(&ctx, mu, CRHBYTES);
-  iosha_squeeze(&ctx, rhoprime, CRHBYTES);
-
-  /* Expand matrix and transform vectors */
-  polyvec_matrix_expand(mat, rho);
-  polyvecl_ntt(&s1);
-  polyveck_ntt(&s2);
-  polyveck_ntt(&t0);
+  /* --- rhoprime = CRH(key ∥ rnd ∥ mu), continuing from the key prefix --- */
+  ctx = ssk->rhoprime_prefix;
+  sym->crh_absorb(&ctx, rnd, RNDBYTES);
+  sym->crh_absorb(&ctx, mu, CRHBYTES);
+  sym->crh_squeeze(&ctx, rhoprime, CRHBYTES);
 
 rej:
   /* Sample intermediate vector y */
-  polyvecl_uniform_gamma1(&y, rhoprime, nonce++);
+  polyvecl_uniform_gamma1(&y, rhoprime, nonce++, sym);
 
   /* Matrix-vector multiplication */
   z = y;
   polyvecl_ntt(&z);
-  polyvec_matrix_pointwise_montgomery(&w1, mat, &z);
+  polyvec_matrix_pointwise_montgomery(&w1, ssk->mat, &z);
   polyveck_reduce(&w1);
   polyveck_invntt_tomont(&w1);
 
@@ -131,46 +234,81 @@ rej:
   polyveck_decompose(&w1, &w0, &w1);
   polyveck_pack_w1(sig, &w1);
 
-  /* --- challenge = CRH(mu ∥ packed_w1) via IOSHA-v2 --- */
-  iosha_init(&ctx, 0x02);
-  iosha_absorb(&ctx, mu, CRHBYTES);
-  iosha_absorb(&ctx, sig, K * POLYW1_PACKEDBYTES);
-  iosha_squeeze(&ctx, sig, CTILDEBYTES);
-  poly_challenge(&cp, sig);
-  poly_ntt(&cp);
-
-  /* Compute z, reject if it reveals secret */
-  polyvecl_pointwise_poly_montgomery(&z, &cp, &s1);
-  polyvecl_invntt_tomont(&z);
-  polyvecl_add(&z, &z, &y);
-  polyvecl_reduce(&z);
-  if (polyvecl_chknorm(&z, GAMMA1 - BETA))
-    goto rej;
-
-  /* Check hints and rejection */
-  polyveck_pointwise_poly_montgomery(&h, &cp, &s2);
-  polyveck_invntt_tomont(&h);
-  polyveck_sub(&w0, &w0, &h);
-  polyveck_reduce(&w0);
-  if (polyveck_chknorm(&w0, GAMMA2 - BETA))
-    goto rej;
-
-  polyveck_pointwise_poly_montgomery(&h, &cp, &t0);
-  polyveck_invntt_tomont(&h);
-  polyveck_reduce(&h);
-  if (polyveck_chknorm(&h, GAMMA2))
-    goto rej;
-
-  polyveck_add(&w0, &w0, &h);
-  n = polyveck_make_hint(&h, &w0, &w1);
-  if (n > OMEGA)
-    goto rej;
+  /* --- challenge = CRH(mu ∥ packed_w1) --- */
+  sym->crh_init(&ctx);
+  sym->crh_absorb(&ctx, mu, CRHBYTES);
+  sym->crh_absorb(&ctx, sig, K * POLYW1_PACKEDBYTES);
+  sym->crh_squeeze(&ctx, sig, CTILDEBYTES);
+  poly_challenge(&cp, sig, sym);
+  poly_sparse_from_challenge(&c, &cp);
+
+  /* The products with the sparse c are exact and small, so they need
+     neither NTTs nor reductions. Each polynomial is finished and checked
+     on its own so a rejected y stops at the first bound it breaks; like
+     the coefficient in poly_chknorm, which polynomial that was does not
+     depend on the secret. Every check costs one sparse product per
+     polynomial, so the one that fails most often goes first: w0 - c*s2,
+     then z, then c*t0 and the hint count, which rarely fail. */
+
+  /* Check w0 - c*s2, reject if it reveals secret */
+  for(i = 0; i < K; ++i) {
+    poly_sparse_mul_sub(&w0.vec[i], &c, &ssk->s2.vec[i]);
+    if(poly_chknorm(&w0.vec[i], GAMMA2 - BETA))
+      goto rej;
+  }
+
+  /* Compute z = y + c*s1, reject if it reveals secret */
+  for(i = 0; i < L; ++i) {
+    z.vec[i] = y.vec[i];
+    poly_sparse_mul_add(&z.vec[i], &c, &ssk->s1.vec[i]);
+    if(poly_chknorm(&z.vec[i], GAMMA1 - BETA))
+      goto rej;
+  }
+
+  /* Check c*t0 and compute hints, reject if there are too many */
+  n = 0;
+  for(i = 0; i < K; ++i) {
+    poly_sparse_mul(&h.vec[i], &c, &ssk->t0.vec[i]);
+    if(poly_chknorm(&h.vec[i], GAMMA2))
+      goto rej;
+    poly_add(&w0.vec[i], &w0.vec[i], &h.vec[i]);
+    n += poly_make_hint(&h.vec[i], &w0.vec[i], &w1.vec[i]);
+    if(n > OMEGA)
+      goto rej;
+  }
 
   /* Write signature */
   pack_sig(sig, sig, &z, &h);
   *siglen = CRYPTO_BYTES;
   return 0;
 }
+
+/*************************************************
+* Name:        crypto_sign_signature_key_internal
+* Description: Computes signature from a prepared signing context.
+*              Internal API.
+**************************************************/
+int crypto_sign_signature_key_internal(uint8_t *sig,
+                                       size_t *siglen,
+                                       const uint8_t *m,
+                                       size_t mlen,
+                                       const uint8_t *pre,
+                                       size_t prelen,
+                                       const uint8_t rnd[RNDBYTES],
+                                       const dilithium_signing_key *ssk)
+{
+  uint8_t mu[CRHBYTES];
+  crh_state ctx;
+
+  /* --- mu = CRH(tr ∥ pre ∥ m), continuing from the tr prefix --- */
+  ctx = ssk->mu_prefix;
+  ssk->sym->crh_absorb(&ctx, pre, prelen);
+  absorb_message(&ctx, m, mlen, ssk->sym);
+  ssk->sym->crh_squeeze(&ctx, mu, CRHBYTES);
+
+  return sign_mu(sig, siglen, mu, rnd, ssk);
+}
+
 /*************************************************
 * Name:        crypto_sign_signature
 *
@@ -218,6 +356,53 @@ int crypto_sign_signature(uint8_t *sig,
   return 0;
 }
 
+/*************************************************
+* Name:        crypto_sign_signature_key
+*
+* Description: Computes signature like crypto_sign_signature, but from a
+*              signing context prepared by crypto_sign_signing_key_init.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m:     pointer to message to be signed
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - const dilithium_signing_key *ssk: pointer to signing context
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_signature_key(uint8_t *sig,
+                              size_t *siglen,
+                              const uint8_t *m,
+                              size_t mlen,
+                              const uint8_t *ctx,
+                              size_t ctxlen,
+                              const dilithium_signing_key *ssk)
+{
+  size_t i;
+  uint8_t pre[257];
+  uint8_t rnd[RNDBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  pre[0] = 0;
+  pre[1] = ctxlen;
+  for(i = 0; i < ctxlen; i++)
+    pre[2 + i] = ctx[i];
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  rng_fill(ssk->rng, rnd, RNDBYTES);
+#else
+  for(i=0;i<RNDBYTES;i++)
+    rnd[i] = 0;
+#endif
+
+  crypto_sign_signature_key_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,ssk);
+  return 0;
+}
+
 /*************************************************
 * Name:        crypto_sign
 *
@@ -255,70 +440,55 @@ int crypto_sign(uint8_t *sm,
 }
 
 /*************************************************
-* Name:        crypto_sign_verify_internal
-*
-* Description: Verifies signature. Internal API.
-*
-* Arguments:   - uint8_t *m: pointer to input signature
-*              - size_t siglen: length of signature
-*              - const uint8_t *m: pointer to message
-*              - size_t mlen: length of message
-*              - const uint8_t *pre: pointer to prefix string
-*              - size_t prelen: length of prefix string
-*              - const uint8_t *pk: pointer to bit-packed public key
+* Name:        verify_mu
 *
-* Returns 0 if signature could be verified correctly and -1 otherwise
+* Description: Verifies signature against the message representative mu,
+*              given rho and t1hat = NTT(t1 * 2^D) of the public key; A
+*              comes from the matrix cache when one is given.
 **************************************************/
-int crypto_sign_verify_internal(const uint8_t *sig,
-                                size_t siglen,
-                                const uint8_t *m,
-                                size_t mlen,
-                                const uint8_t *pre,
-                                size_t prelen,
-                                const uint8_t *pk)
+static int verify_mu(const uint8_t *sig,
+                     size_t siglen,
+                     const uint8_t mu[CRHBYTES],
+                     const uint8_t rho[SEEDBYTES],
+                     const polyveck *t1hat,
+                     const dilithium_symmetric *sym,
+                     dilithium_matrix_cache *cache)
 {
     unsigned int i;
     uint8_t buf[K * POLYW1_PACKEDBYTES];
-    uint8_t rho[SEEDBYTES];
-    uint8_t mu[CRHBYTES];
     uint8_t c[CTILDEBYTES];
     uint8_t c2[CTILDEBYTES];
     poly cp;
+    poly_sparse sc;
     polyvecl mat[K], z;
+    const polyvecl *a = NULL;
     polyveck t1, w1, h;
-    iosha_ctx ctx;
+    crh_state ctx;
 
     if (siglen != CRYPTO_BYTES)
         return -1;
 
-    /* Unpack public key */
-    unpack_pk(rho, &t1, pk);
-
     /* Unpack signature */
     if (unpack_sig(c, &z, &h, sig))
         return -1;
     if (polyvecl_chknorm(&z, GAMMA1 - BETA))
         return -1;
 
-    /* --- mu = CRH(H(rho, t1) ∥ pre ∥ m) via IOSHA-v2 --- */
-    iosha_crh_bytes(pk, CRYPTO_PUBLICKEYBYTES, buf, TRBYTES);
-    iosha_init(&ctx, 0x02);
-    iosha_absorb(&ctx, buf, TRBYTES);
-    iosha_absorb(&ctx, pre, prelen);
-    iosha_absorb(&ctx, m, mlen);
-    iosha_squeeze(&ctx, mu, CRHBYTES);
-
     /* Matrix-vector multiplication; compute Az - c2 * t1 */
-    poly_challenge(&cp, c);
-    polyvec_matrix_expand(mat, rho);
+    poly_challenge(&cp, c, sym);
+    if (cache)
+        a = matrix_cache_get(cache, rho, sym);
+    if (!a) {
+        polyvec_matrix_expand(mat, rho, sym);
+        a = mat;
+    }
 
     polyvecl_ntt(&z);
-    polyvec_matrix_pointwise_montgomery(&w1, mat, &z);
+    polyvec_matrix_pointwise_montgomery(&w1, a, &z);
 
-    poly_ntt(&cp);
-    polyveck_shiftl(&t1);
-    polyveck_ntt(&t1);
-    polyveck_pointwise_poly_montgomery(&t1, &cp, &t1);
+    poly_sparse_from_challenge(&sc, &cp);
+    poly_sparse_ntt(&cp, &sc);
+    polyveck_pointwise_poly_montgomery(&t1, &cp, t1hat);
 
     polyveck_sub(&w1, &w1, &t1);
     polyveck_reduce(&w1);
@@ -329,11 +499,11 @@ int crypto_sign_verify_internal(const uint8_t *sig,
     polyveck_use_hint(&w1, &w1, &h);
     polyveck_pack_w1(buf, &w1);
 
-    /* --- c2 = CRH(mu ∥ packed_w1) via IOSHA-v2 --- */
-    iosha_init(&ctx, 0x02);
-    iosha_absorb(&ctx, mu, CRHBYTES);
-    iosha_absorb(&ctx, buf, K * POLYW1_PACKEDBYTES);
-    iosha_squeeze(&ctx, c2, CTILDEBYTES);
+    /* --- c2 = CRH(mu ∥ packed_w1) --- */
+    sym->crh_init(&ctx);
+    sym->crh_absorb(&ctx, mu, CRHBYTES);
+    sym->crh_absorb(&ctx, buf, K * POLYW1_PACKEDBYTES);
+    sym->crh_squeeze(&ctx, c2, CTILDEBYTES);
 
     /* Compare challenges */
     for (i = 0; i < CTILDEBYTES; ++i)
@@ -342,6 +512,68 @@ int crypto_sign_verify_internal(const uint8_t *sig,
 
     return 0;
 }
+
+/*************************************************
+* Name:        verify_mu_pk
+*
+* Description: verify_mu on a bit-packed public key.
+**************************************************/
+static int verify_mu_pk(const uint8_t *sig,
+                        size_t siglen,
+                        const uint8_t mu[CRHBYTES],
+                        const uint8_t *pk,
+                        const dilithium_symmetric *sym)
+{
+    uint8_t rho[SEEDBYTES];
+    polyveck t1;
+
+    unpack_pk(rho, &t1, pk);
+    polyveck_shiftl(&t1);
+    polyveck_ntt(&t1);
+    return verify_mu(sig, siglen, mu, rho, &t1, sym, NULL);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_internal
+*
+* Description: Verifies signature. Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_internal(const uint8_t *sig,
+                                size_t siglen,
+                                const uint8_t *m,
+                                size_t mlen,
+                                const uint8_t *pre,
+                                size_t prelen,
+                                const uint8_t *pk)
+{
+    uint8_t tr[TRBYTES];
+    uint8_t mu[CRHBYTES];
+    crh_state ctx;
+    const dilithium_symmetric *sym = &dilithium_symmetric_default;
+
+    if (siglen != CRYPTO_BYTES)
+        return -1;
+
+    /* --- mu = CRH(H(rho, t1) ∥ pre ∥ m) --- */
+    crh(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES, sym);
+    sym->crh_init(&ctx);
+    sym->crh_absorb(&ctx, tr, TRBYTES);
+    sym->crh_absorb(&ctx, pre, prelen);
+    absorb_message(&ctx, m, mlen, sym);
+    sym->crh_squeeze(&ctx, mu, CRHBYTES);
+
+    return verify_mu_pk(sig, siglen, mu, pk, sym);
+}
 /*************************************************
 * Name:        crypto_sign_verify
 *
@@ -426,3 +658,280 @@ badsig:
 
   return -1;
 }
+
+/*************************************************
+* Name:        mu_state_init
+*
+* Description: Starts an incremental mu computation from the CRH state with
+*              tr absorbed and absorbs pre = (0, ctxlen, ctx).
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+static int mu_state_init(dilithium_mu_state *st,
+                         const crh_state *prefix,
+                         const uint8_t *ctx,
+                         size_t ctxlen,
+                         const dilithium_symmetric *sym)
+{
+  uint8_t pre[2];
+
+  if(ctxlen > 255)
+    return -1;
+
+  pre[0] = 0;
+  pre[1] = ctxlen;
+  st->sym = sym;
+  st->crh = *prefix;
+  sym->crh_absorb(&st->crh, pre, 2);
+  sym->crh_absorb(&st->crh, ctx, ctxlen);
+#ifdef DILITHIUM_TREE_MU
+  iosha_tree_init(&st->tree);
+#endif
+  return 0;
+}
+
+static void mu_state_update(dilithium_mu_state *st, const uint8_t *m, size_t mlen)
+{
+#ifdef DILITHIUM_TREE_MU
+  iosha_tree_update(&st->tree, m, mlen);
+#else
+  st->sym->crh_absorb(&st->crh, m, mlen);
+#endif
+}
+
+static void mu_state_final(dilithium_mu_state *st, uint8_t mu[CRHBYTES])
+{
+#ifdef DILITHIUM_TREE_MU
+  uint8_t root[CRHBYTES];
+
+  iosha_tree_final(&st->tree, root, CRHBYTES);
+  st->sym->crh_absorb(&st->crh, root, CRHBYTES);
+#endif
+  st->sym->crh_squeeze(&st->crh, mu, CRHBYTES);
+}
+
+/*************************************************
+* Name:        crypto_sign_init
+*
+* Description: Starts a streaming signature. The message is passed in
+*              pieces to crypto_sign_update and the signature is produced
+*              by crypto_sign_final; the result equals crypto_sign_signature
+*              on the concatenated message. The secret key is unpacked
+*              and A expanded on every call; crypto_sign_init_key reuses a
+*              prepared key instead.
+*
+* Arguments:   - dilithium_sign_ctx *st: pointer to streaming state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *sk: pointer to bit-packed secret key
+*              - const dilithium_symmetric *sym: hash backend (NULL for
+*                the default)
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_init(dilithium_sign_ctx *st,
+                     const uint8_t *ctx,
+                     size_t ctxlen,
+                     const uint8_t *sk,
+                     const dilithium_symmetric *sym)
+{
+  if(ctxlen > 255)
+    return -1;
+
+  crypto_sign_signing_key_init(&st->own, sk, sym, NULL);
+  st->key = NULL;
+  return mu_state_init(&st->mu, &st->own.mu_prefix, ctx, ctxlen, st->own.sym);
+}
+
+/*************************************************
+* Name:        crypto_sign_init_key
+*
+* Description: crypto_sign_init for a prepared signing key, which must
+*              outlive the streaming state; nothing is unpacked or
+*              expanded per signature.
+*
+* Arguments:   - dilithium_sign_ctx *st: pointer to streaming state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const dilithium_signing_key *ssk: pointer to signing key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_init_key(dilithium_sign_ctx *st,
+                         const uint8_t *ctx,
+                         size_t ctxlen,
+                         const dilithium_signing_key *ssk)
+{
+  st->key = ssk;
+  return mu_state_init(&st->mu, &ssk->mu_prefix, ctx, ctxlen, ssk->sym);
+}
+
+void crypto_sign_update(dilithium_sign_ctx *st, const uint8_t *m, size_t mlen)
+{
+  mu_state_update(&st->mu, m, mlen);
+}
+
+int crypto_sign_final(dilithium_sign_ctx *st, uint8_t *sig, size_t *siglen)
+{
+  uint8_t mu[CRHBYTES];
+  uint8_t rnd[RNDBYTES];
+  const dilithium_signing_key *ssk = st->key ? st->key : &st->own;
+
+  mu_state_final(&st->mu, mu);
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  rng_fill(ssk->rng, rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  return sign_mu(sig, siglen, mu, rnd, ssk);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_init
+*
+* Description: Starts a streaming verification, the counterpart of
+*              crypto_sign_init. The public key is copied into the state.
+*
+* Arguments:   - dilithium_verify_ctx *st: pointer to streaming state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*              - const dilithium_symmetric *sym: hash backend (NULL for
+*                the default)
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_verify_init(dilithium_verify_ctx *st,
+                            const uint8_t *ctx,
+                            size_t ctxlen,
+                            const uint8_t *pk,
+                            const dilithium_symmetric *sym)
+{
+  size_t i;
+  uint8_t tr[TRBYTES];
+  crh_state prefix;
+
+  if(ctxlen > 255)
+    return -1;
+
+  for(i = 0; i < CRYPTO_PUBLICKEYBYTES; ++i)
+    st->pk[i] = pk[i];
+  st->key = NULL;
+
+  sym = backend(sym);
+  crh(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES, sym);
+  sym->crh_init(&prefix);
+  sym->crh_absorb(&prefix, tr, TRBYTES);
+  return mu_state_init(&st->mu, &prefix, ctx, ctxlen, sym);
+}
+
+/*************************************************
+* Name:        crypto_sign_public_key_init
+*
+* Description: Prepares a public key for repeated verification: unpacks
+*              it, keeps t1hat = NTT(t1 * 2^D) and the CRH prefix state
+*              with tr absorbed, so a verification only unpacks the
+*              signature, computes Az - c*t1hat and runs the two hashes.
+*
+* Arguments:   - dilithium_public_key *key: pointer to output handle
+*              - const uint8_t *pk: pointer to bit-packed public key
+*              - const dilithium_symmetric *sym: hash backend (NULL for
+*                the default)
+*              - dilithium_matrix_cache *cache: cache for the expanded A,
+*                shared by any number of handles (NULL: expand A on every
+*                verification)
+**************************************************/
+void crypto_sign_public_key_init(dilithium_public_key *key,
+                                 const uint8_t *pk,
+                                 const dilithium_symmetric *sym,
+                                 dilithium_matrix_cache *cache)
+{
+  uint8_t tr[TRBYTES];
+
+  key->sym = sym = backend(sym);
+  key->cache = cache;
+
+  unpack_pk(key->rho, &key->t1, pk);
+  polyveck_shiftl(&key->t1);
+  polyveck_ntt(&key->t1);
+
+  crh(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES, sym);
+  sym->crh_init(&key->mu_prefix);
+  sym->crh_absorb(&key->mu_prefix, tr, TRBYTES);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_init_key
+*
+* Description: crypto_sign_verify_init for a prepared public key, which
+*              must outlive the streaming state.
+*
+* Arguments:   - dilithium_verify_ctx *st: pointer to streaming state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const dilithium_public_key *key: pointer to key handle
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_verify_init_key(dilithium_verify_ctx *st,
+                                const uint8_t *ctx,
+                                size_t ctxlen,
+                                const dilithium_public_key *key)
+{
+  st->key = key;
+  return mu_state_init(&st->mu, &key->mu_prefix, ctx, ctxlen, key->sym);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_key
+*
+* Description: crypto_sign_verify with a prepared public key.
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const dilithium_public_key *key: pointer to key handle
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_key(const uint8_t *sig,
+                           size_t siglen,
+                           const uint8_t *m,
+                           size_t mlen,
+                           const uint8_t *ctx,
+                           size_t ctxlen,
+                           const dilithium_public_key *key)
+{
+  dilithium_verify_ctx st;
+
+  if(crypto_sign_verify_init_key(&st, ctx, ctxlen, key))
+    return -1;
+  crypto_sign_verify_update(&st, m, mlen);
+  return crypto_sign_verify_final(&st, sig, siglen);
+}
+
+void crypto_sign_verify_update(dilithium_verify_ctx *st,
+                               const uint8_t *m,
+                               size_t mlen)
+{
+  mu_state_update(&st->mu, m, mlen);
+}
+
+/* Returns 0 if signature could be verified correctly and -1 otherwise */
+int crypto_sign_verify_final(dilithium_verify_ctx *st,
+                             const uint8_t *sig,
+                             size_t siglen)
+{
+  uint8_t mu[CRHBYTES];
+
+  mu_state_final(&st->mu, mu);
+  if(st->key)
+    return verify_mu(sig, siglen, mu, st->key->rho, &st->key->t1, st->mu.sym,
+                     st->key->cache);
+  return verify_mu_pk(sig, siglen, mu, st->pk, st->mu.sym);
+}
@@ -6,10 +6,65 @@
 #include "params.h"
 #include "polyvec.h"
 #include "poly.h"
+#include "symmetric.h"
+#include "matcache.h"
+#include "randombytes.h"
+
+/* Secret key unpacked once for repeated signing, with everything that
+   does not depend on the message precomputed */
+typedef struct {
+  const dilithium_symmetric *sym;
+  const randombytes_rng *rng; /* source of rnd; NULL: randombytes() */
+  polyvecl mat[K];            /* A = ExpandA(rho)           */
+  polyvecl s1;
+  polyveck s2, t0;
+  crh_state mu_prefix;        /* CRH state with tr absorbed  */
+  crh_state rhoprime_prefix;  /* CRH state with key absorbed */
+} dilithium_signing_key;
+
+/* Incremental mu = CRH(tr ∥ pre ∥ m) for the streaming API */
+typedef struct {
+  const dilithium_symmetric *sym;
+  crh_state crh;
+#ifdef DILITHIUM_TREE_MU
+  iosha_tree_ctx tree;
+#endif
+} dilithium_mu_state;
+
+typedef struct {
+  dilithium_signing_key own;          /* unpacked by crypto_sign_init   */
+  const dilithium_signing_key *key;   /* set by crypto_sign_init_key    */
+  dilithium_mu_state mu;
+} dilithium_sign_ctx;
+
+/* Public key prepared once for repeated verification; handles on a
+   matrix cache expand A once per rho rather than once per signature */
+typedef struct {
+  const dilithium_symmetric *sym;
+  dilithium_matrix_cache *cache;  /* NULL: expand A every time */
+  uint8_t rho[SEEDBYTES];
+  polyveck t1;                    /* NTT(t1 * 2^D)              */
+  crh_state mu_prefix;            /* CRH state with tr absorbed */
+} dilithium_public_key;
+
+typedef struct {
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  const dilithium_public_key *key;  /* set by crypto_sign_verify_init_key */
+  dilithium_mu_state mu;
+} dilithium_verify_ctx;
 
 #define crypto_sign_keypair DILITHIUM_NAMESPACE(keypair)
 int crypto_sign_keypair(uint8_t *pk, uint8_t *sk);
 
+#define crypto_sign_keypair_sym DILITHIUM_NAMESPACE(keypair_sym)
+int crypto_sign_keypair_sym(uint8_t *pk, uint8_t *sk,
+                            const dilithium_symmetric *sym);
+
+#define crypto_sign_keypair_rng DILITHIUM_NAMESPACE(keypair_rng)
+int crypto_sign_keypair_rng(uint8_t *pk, uint8_t *sk,
+                            const dilithium_symmetric *sym,
+                            const randombytes_rng *rng);
+
 #define crypto_sign_signature_internal DILITHIUM_NAMESPACE(signature_internal)
 int crypto_sign_signature_internal(uint8_t *sig,
                                    size_t *siglen,
@@ -20,12 +75,34 @@ int crypto_sign_signature_internal(uint8_t *sig,
                                    const uint8_t rnd[RNDBYTES],
                                    const uint8_t *sk);
 
+#define crypto_sign_signing_key_init DILITHIUM_NAMESPACE(signing_key_init)
+void crypto_sign_signing_key_init(dilithium_signing_key *ssk,
+                                  const uint8_t *sk,
+                                  const dilithium_symmetric *sym,
+                                  const randombytes_rng *rng);
+
+#define crypto_sign_signature_key_internal DILITHIUM_NAMESPACE(signature_key_internal)
+int crypto_sign_signature_key_internal(uint8_t *sig,
+                                       size_t *siglen,
+                                       const uint8_t *m,
+                                       size_t mlen,
+                                       const uint8_t *pre,
+                                       size_t prelen,
+                                       const uint8_t rnd[RNDBYTES],
+                                       const dilithium_signing_key *ssk);
+
 #define crypto_sign_signature DILITHIUM_NAMESPACE(signature)
 int crypto_sign_signature(uint8_t *sig, size_t *siglen,
                           const uint8_t *m, size_t mlen,
                           const uint8_t *ctx, size_t ctxlen,
                           const uint8_t *sk);
 
+#define crypto_sign_signature_key DILITHIUM_NAMESPACE(signature_key)
+int crypto_sign_signature_key(uint8_t *sig, size_t *siglen,
+                              const uint8_t *m, size_t mlen,
+                              const uint8_t *ctx, size_t ctxlen,
+                              const dilithium_signing_key *ssk);
+
 #define crypto_sign DILITHIUM_NAMESPACETOP
 int crypto_sign(uint8_t *sm, size_t *smlen,
                 const uint8_t *m, size_t mlen,
@@ -53,4 +130,52 @@ int crypto_sign_open(uint8_t *m, size_t *mlen,
                      const uint8_t *ctx, size_t ctxlen,
                      const uint8_t *pk);
 
+#define crypto_sign_init DILITHIUM_NAMESPACE(sign_init)
+int crypto_sign_init(dilithium_sign_ctx *st,
+                     const uint8_t *ctx, size_t ctxlen,
+                     const uint8_t *sk,
+                     const dilithium_symmetric *sym);
+
+#define crypto_sign_init_key DILITHIUM_NAMESPACE(sign_init_key)
+int crypto_sign_init_key(dilithium_sign_ctx *st,
+                         const uint8_t *ctx, size_t ctxlen,
+                         const dilithium_signing_key *ssk);
+
+#define crypto_sign_update DILITHIUM_NAMESPACE(sign_update)
+void crypto_sign_update(dilithium_sign_ctx *st, const uint8_t *m, size_t mlen);
+
+#define crypto_sign_final DILITHIUM_NAMESPACE(sign_final)
+int crypto_sign_final(dilithium_sign_ctx *st, uint8_t *sig, size_t *siglen);
+
+#define crypto_sign_verify_init DILITHIUM_NAMESPACE(verify_init)
+int crypto_sign_verify_init(dilithium_verify_ctx *st,
+                            const uint8_t *ctx, size_t ctxlen,
+                            const uint8_t *pk,
+                            const dilithium_symmetric *sym);
+
+#define crypto_sign_public_key_init DILITHIUM_NAMESPACE(public_key_init)
+void crypto_sign_public_key_init(dilithium_public_key *key,
+                                 const uint8_t *pk,
+                                 const dilithium_symmetric *sym,
+                                 dilithium_matrix_cache *cache);
+
+#define crypto_sign_verify_init_key DILITHIUM_NAMESPACE(verify_init_key)
+int crypto_sign_verify_init_key(dilithium_verify_ctx *st,
+                                const uint8_t *ctx, size_t ctxlen,
+                                const dilithium_public_key *key);
+
+#define crypto_sign_verify_key DILITHIUM_NAMESPACE(verify_key)
+int crypto_sign_verify_key(const uint8_t *sig, size_t siglen,
+                           const uint8_t *m, size_t mlen,
+                           const uint8_t *ctx, size_t ctxlen,
+                           const dilithium_public_key *key);
+
+#define crypto_sign_verify_update DILITHIUM_NAMESPACE(verify_update)
+void crypto_sign_verify_update(dilithium_verify_ctx *st,
+                               const uint8_t *m, size_t mlen);
+
+#define crypto_sign_verify_final DILITHIUM_NAMESPACE(verify_final)
+int crypto_sign_verify_final(dilithium_verify_ctx *st,
+                             const uint8_t *sig, size_t siglen);
+
 #endif
@@ -0,0 +1,351 @@
+#include <stdint.h>
+#include "params.h"
+#include "sparse.h"
+#include "poly.h"
+#include "ntt.h"
+#include "reduce.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if SPARSE_NTT_COLUMNS < 2 || SPARSE_NTT_COLUMNS > N || \
+    (SPARSE_NTT_COLUMNS & (SPARSE_NTT_COLUMNS - 1))
+#error "SPARSE_NTT_COLUMNS must be a power of two from 2 to N"
+#endif
+#define SPARSE_NTT_GROUPS (N/SPARSE_NTT_COLUMNS)
+
+/* The AVX2 kernel is compiled with a target attribute and picked at run
+   time, so the default build flags stay portable. */
+#if !defined(SPARSE_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(_M_X64))
+#define SPARSE_AVX2
+#include <immintrin.h>
+#define SPARSE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/*************************************************
+* Name:        poly_sparse_from_challenge
+*
+* Description: Lists the nonzero coefficients of a challenge polynomial
+*              from poly_challenge.
+*
+* Arguments:   - poly_sparse *c: pointer to output sparse challenge
+*              - const poly *cp: pointer to challenge polynomial with TAU
+*                coefficients in {-1, 1} and the rest zero
+**************************************************/
+void poly_sparse_from_challenge(poly_sparse *c, const poly *cp)
+{
+  unsigned int i, j;
+
+  c->neg = 0;
+  for(i = j = 0; i < N; ++i) {
+    if(cp->coeffs[i]) {
+      c->pos[j] = i;
+      c->neg |= (uint64_t)(cp->coeffs[i] < 0) << j;
+      ++j;
+    }
+  }
+}
+
+/* With u = (a, -a, a), X^p * a is the window u[2N-p .. 3N-p) and
+   -X^p * a the window u[N-p .. 2N-p): every product term is one
+   contiguous add, whatever the sign and wrap-around. */
+static void sparse_windows(int32_t u[3*N],
+                           unsigned int off[TAU],
+                           const poly_sparse *c,
+                           uint64_t neg,
+                           const poly *a)
+{
+  unsigned int i;
+
+  for(i = 0; i < N; ++i) {
+    u[i] = a->coeffs[i];
+    u[N+i] = -a->coeffs[i];
+    u[2*N+i] = a->coeffs[i];
+  }
+  for(i = 0; i < TAU; ++i)
+    off[i] = ((neg >> i & 1) ? N : 2*N) - c->pos[i];
+}
+
+static void sparse_acc_ref(poly *r, const int32_t u[3*N], const unsigned int off[TAU])
+{
+  unsigned int i, j;
+  const int32_t *w;
+
+  for(j = 0; j < TAU; ++j) {
+    w = &u[off[j]];
+    for(i = 0; i < N; ++i)
+      r->coeffs[i] += w[i];
+  }
+}
+
+#ifdef SPARSE_AVX2
+/* Same sums, 64 coefficients at a time kept in eight accumulators */
+SPARSE_TARGET_AVX2
+static void sparse_acc_avx2(poly *r, const int32_t u[3*N], const unsigned int off[TAU])
+{
+  unsigned int i, j, k;
+  const int32_t *w;
+  __m256i acc[8];
+
+  for(i = 0; i < N; i += 64) {
+    for(k = 0; k < 8; ++k)
+      acc[k] = _mm256_loadu_si256((const __m256i *)&r->coeffs[i+8*k]);
+    for(j = 0; j < TAU; ++j) {
+      w = &u[off[j] + i];
+      for(k = 0; k < 8; ++k)
+        acc[k] = _mm256_add_epi32(acc[k],
+                   _mm256_loadu_si256((const __m256i *)&w[8*k]));
+    }
+    for(k = 0; k < 8; ++k)
+      _mm256_storeu_si256((__m256i *)&r->coeffs[i+8*k], acc[k]);
+  }
+}
+#endif
+
+static void sparse_acc(poly *r, const poly_sparse *c, uint64_t neg, const poly *a)
+{
+  int32_t u[3*N];
+  unsigned int off[TAU];
+
+  sparse_windows(u, off, c, neg, a);
+#ifdef SPARSE_AVX2
+  if(__builtin_cpu_supports("avx2")) {
+    sparse_acc_avx2(r, u, off);
+    return;
+  }
+#endif
+  sparse_acc_ref(r, u, off);
+}
+
+/*************************************************
+* Name:        poly_sparse_mul
+*
+* Description: Negacyclic product r = c*a in the normal domain, without
+*              reduction; exact as long as |a| < 2^31/TAU.
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a)
+{
+  unsigned int i;
+
+  for(i = 0; i < N; ++i)
+    r->coeffs[i] = 0;
+  sparse_acc(r, c, c->neg, a);
+}
+
+/*************************************************
+* Name:        poly_sparse_mul_add
+*
+* Description: Negacyclic multiply-accumulate r += c*a in the normal
+*              domain, without reduction; exact as long as the sums fit
+*              in int32.
+*
+* Arguments:   - poly *r: pointer to input/output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul_add(poly *r, const poly_sparse *c, const poly *a)
+{
+  sparse_acc(r, c, c->neg, a);
+}
+
+/*************************************************
+* Name:        poly_sparse_mul_sub
+*
+* Description: Negacyclic multiply-subtract r -= c*a in the normal domain,
+*              without reduction.
+*
+* Arguments:   - poly *r: pointer to input/output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul_sub(poly *r, const poly_sparse *c, const poly *a)
+{
+  sparse_acc(r, c, ~c->neg, a);
+}
+
+/* ntt_cols[r] = NTT(X^r) reduced; ntt_mults[g] = NTT(X^(g*COLUMNS)) in
+   Montgomery form, so X^p with p = g*COLUMNS + r is their product */
+static int32_t ntt_cols[SPARSE_NTT_COLUMNS][N];
+#if SPARSE_NTT_GROUPS > 1
+static int32_t ntt_mults[SPARSE_NTT_GROUPS][N];
+#endif
+
+static void ntt_table_init(void)
+{
+  unsigned int i, j;
+  int32_t t[N];
+
+  for(j = 0; j < SPARSE_NTT_COLUMNS; ++j) {
+    for(i = 0; i < N; ++i)
+      t[i] = (i == j);
+    ntt(t);
+    for(i = 0; i < N; ++i)
+      ntt_cols[j][i] = reduce32(t[i]);
+  }
+#if SPARSE_NTT_GROUPS > 1
+  for(j = 0; j < SPARSE_NTT_GROUPS; ++j) {
+    for(i = 0; i < N; ++i)
+      t[i] = (i == j*SPARSE_NTT_COLUMNS);
+    ntt(t);
+    for(i = 0; i < N; ++i)
+      ntt_mults[j][i] = (int64_t)t[i] * ((int64_t)1 << 32) % Q;
+  }
+#endif
+}
+
+#ifdef _WIN32
+static INIT_ONCE ntt_table_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK ntt_table_init_once(PINIT_ONCE once, PVOID param, PVOID *ctx)
+{
+  (void)once;
+  (void)param;
+  (void)ctx;
+  ntt_table_init();
+  return TRUE;
+}
+#else
+static pthread_once_t ntt_table_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void column_acc_ref(int32_t acc[N], const int32_t col[N], int neg)
+{
+  unsigned int i;
+
+  if(neg)
+    for(i = 0; i < N; ++i)
+      acc[i] -= col[i];
+  else
+    for(i = 0; i < N; ++i)
+      acc[i] += col[i];
+}
+
+#ifdef SPARSE_AVX2
+SPARSE_TARGET_AVX2
+static void column_acc_avx2(int32_t acc[N], const int32_t col[N], int neg)
+{
+  unsigned int i;
+  __m256i a, b;
+
+  for(i = 0; i < N; i += 8) {
+    a = _mm256_loadu_si256((const __m256i *)&acc[i]);
+    b = _mm256_loadu_si256((const __m256i *)&col[i]);
+    a = neg ? _mm256_sub_epi32(a, b) : _mm256_add_epi32(a, b);
+    _mm256_storeu_si256((__m256i *)&acc[i], a);
+  }
+}
+#endif
+
+static void column_acc(int32_t acc[N], const int32_t col[N], int neg)
+{
+#ifdef SPARSE_AVX2
+  if(__builtin_cpu_supports("avx2")) {
+    column_acc_avx2(acc, col, neg);
+    return;
+  }
+#endif
+  column_acc_ref(acc, col, neg);
+}
+
+#if SPARSE_NTT_GROUPS > 1
+static void shift_acc_ref(int32_t r[N], const int32_t acc[N], const int32_t mult[N])
+{
+  unsigned int i;
+
+  for(i = 0; i < N; ++i)
+    r[i] += montgomery_reduce((int64_t)acc[i] * mult[i]);
+}
+
+#ifdef SPARSE_AVX2
+/* montgomery_reduce on the even and the odd 32-bit lanes separately; the
+   low half of a - t*Q is zero, so the high halves are the results */
+SPARSE_TARGET_AVX2
+static void shift_acc_avx2(int32_t r[N], const int32_t acc[N], const int32_t mult[N])
+{
+  unsigned int i;
+  const __m256i qinv = _mm256_set1_epi32(QINV);
+  const __m256i q = _mm256_set1_epi32(Q);
+  __m256i a, b, lo, hi, t;
+
+  for(i = 0; i < N; i += 8) {
+    a = _mm256_loadu_si256((const __m256i *)&acc[i]);
+    b = _mm256_loadu_si256((const __m256i *)&mult[i]);
+    lo = _mm256_mul_epi32(a, b);
+    t = _mm256_mul_epi32(lo, qinv);
+    lo = _mm256_sub_epi64(lo, _mm256_mul_epi32(t, q));
+    hi = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    t = _mm256_mul_epi32(hi, qinv);
+    hi = _mm256_sub_epi64(hi, _mm256_mul_epi32(t, q));
+    t = _mm256_blend_epi32(_mm256_srli_epi64(lo, 32), hi, 0xAA);
+    a = _mm256_loadu_si256((const __m256i *)&r[i]);
+    _mm256_storeu_si256((__m256i *)&r[i], _mm256_add_epi32(a, t));
+  }
+}
+#endif
+
+static void shift_acc(int32_t r[N], const int32_t acc[N], const int32_t mult[N])
+{
+#ifdef SPARSE_AVX2
+  if(__builtin_cpu_supports("avx2")) {
+    shift_acc_avx2(r, acc, mult);
+    return;
+  }
+#endif
+  shift_acc_ref(r, acc, mult);
+}
+#endif
+
+/*************************************************
+* Name:        poly_sparse_ntt
+*
+* Description: NTT of a sparse challenge from precomputed columns: the
+*              signed columns NTT(X^r) of the positions in each group of
+*              SPARSE_NTT_COLUMNS are added up, and each group sum is
+*              shifted into place by one pointwise product. The result
+*              is congruent to poly_ntt of the dense challenge, with
+*              coefficients in [-6283008, 6283008].
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+**************************************************/
+void poly_sparse_ntt(poly *r, const poly_sparse *c)
+{
+  unsigned int i, j, k, g;
+  int32_t acc[N];
+
+#ifdef _WIN32
+  InitOnceExecuteOnce(&ntt_table_once, ntt_table_init_once, NULL, NULL);
+#else
+  pthread_once(&ntt_table_once, ntt_table_init);
+#endif
+
+  for(k = 0; k < N; ++k)
+    r->coeffs[k] = 0;
+
+  /* pos[] is increasing, so each group is one run of it */
+  for(j = 0; j < TAU; j = i) {
+    g = c->pos[j] / SPARSE_NTT_COLUMNS;
+    for(k = 0; k < N; ++k)
+      acc[k] = 0;
+    for(i = j; i < TAU && c->pos[i] / SPARSE_NTT_COLUMNS == g; ++i)
+      column_acc(acc, ntt_cols[c->pos[i] % SPARSE_NTT_COLUMNS], c->neg >> i & 1);
+
+#if SPARSE_NTT_GROUPS > 1
+    shift_acc(r->coeffs, acc, ntt_mults[g]);
+#else
+    for(k = 0; k < N; ++k)
+      r->coeffs[k] = acc[k];
+#endif
+  }
+
+  for(k = 0; k < N; ++k)
+    r->coeffs[k] = reduce32(r->coeffs[k]);
+}
@@ -0,0 +1,40 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+
+/* poly_sparse_ntt keeps NTT(X^r) for r < SPARSE_NTT_COLUMNS and, below
+   N, one shift column per group of that many positions: about
+   SPARSE_NTT_COLUMNS + N/SPARSE_NTT_COLUMNS KiB of table against
+   N/SPARSE_NTT_COLUMNS pointwise products per call on top of the TAU
+   column additions. A power of two from 2 to N; below 32 the products
+   cost more than the dense transform. */
+#ifndef SPARSE_NTT_COLUMNS
+#define SPARSE_NTT_COLUMNS 64
+#endif
+
+/* Challenge c as the positions of its TAU nonzero coefficients; bit j of
+   neg is set when the coefficient at pos[j] is -1 */
+typedef struct {
+  uint8_t pos[TAU];
+  uint64_t neg;
+} poly_sparse;
+
+#define poly_sparse_from_challenge DILITHIUM_NAMESPACE(poly_sparse_from_challenge)
+void poly_sparse_from_challenge(poly_sparse *c, const poly *cp);
+
+#define poly_sparse_mul DILITHIUM_NAMESPACE(poly_sparse_mul)
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a);
+
+#define poly_sparse_mul_add DILITHIUM_NAMESPACE(poly_sparse_mul_add)
+void poly_sparse_mul_add(poly *r, const poly_sparse *c, const poly *a);
+
+#define poly_sparse_mul_sub DILITHIUM_NAMESPACE(poly_sparse_mul_sub)
+void poly_sparse_mul_sub(poly *r, const poly_sparse *c, const poly *a);
+
+#define poly_sparse_ntt DILITHIUM_NAMESPACE(poly_sparse_ntt)
+void poly_sparse_ntt(poly *r, const poly_sparse *c);
+
+#endif
@@ -0,0 +1,229 @@
+/*  symmetric-iosha.c  –  Dilithium symmetric primitives on IOSHA-v2  */
+#include <string.h>
+#include "symmetric.h"
+
+/* ---------------- CRH: tag 0x02, rate 64 ------------------------------ */
+/* iosha_squeeze pads on every call; callers that squeeze more than once
+   (poly_challenge) rely on exactly that output. */
+static void iosha_crh_init(crh_state *st)
+{
+    iosha_init(&st->s.iosha, 0x02);
+}
+
+static void iosha_crh_absorb(crh_state *st, const uint8_t *in, size_t inlen)
+{
+    iosha_absorb(&st->s.iosha, in, inlen);
+}
+
+static void iosha_crh_squeeze(crh_state *st, uint8_t *out, size_t outlen)
+{
+    iosha_squeeze(&st->s.iosha, out, outlen);
+}
+
+/* ---------------- 128-bit security stream (was SHAKE-128) ------------- */
+static void iosha_stream128_init(stream128_state *st,
+                                 const uint8_t seed[SEEDBYTES],
+                                 uint16_t      nonce)
+{
+    iosha_ctx *ctx = &st->iosha;
+    iosha_init_128(ctx, 0x01);                       /* domain tag 0x01 = XOF */
+
+    uint8_t t[2] = { (uint8_t)nonce, (uint8_t)(nonce >> 8) };
+    iosha_absorb_128(ctx, seed, SEEDBYTES);          /* absorb seed */
+    iosha_absorb_128(ctx, t, 2);                     /* absorb nonce */
+#if IOSHA_XOF_VERSION != 1
+    iosha_finalize(ctx);                             /* pad once */
+#endif
+}
+
+static void iosha_stream128_squeezeblocks(uint8_t       *out,
+                                          size_t         nblocks,
+                                          stream128_state *st)
+{
+#if IOSHA_XOF_VERSION == 1
+    iosha_squeeze_128(&st->iosha, out,
+                      nblocks * STREAM128_BLOCKBYTES);   /* 32-byte blocks */
+#else
+    iosha_squeezeblocks(out, nblocks, &st->iosha); /* 96-byte blocks */
+#endif
+}
+
+/* ---------------- 256-bit security stream (was SHAKE-256) ------------- */
+static void iosha_stream256_init(stream256_state *st,
+                                 const uint8_t seed[CRHBYTES],
+                                 uint16_t      nonce)
+{
+    iosha_ctx *ctx = &st->iosha;
+    iosha_init(ctx, 0x01);                       /* same XOF tag */
+
+    uint8_t t[2] = { (uint8_t)nonce, (uint8_t)(nonce >> 8) };
+    iosha_absorb(ctx, seed, CRHBYTES);
+    iosha_absorb(ctx, t, 2);
+#if IOSHA_XOF_VERSION != 1
+    iosha_finalize(ctx);
+#endif
+}
+
+static void iosha_stream256_squeezeblocks(uint8_t       *out,
+                                          size_t         nblocks,
+                                          stream256_state *st)
+{
+#if IOSHA_XOF_VERSION == 1
+    iosha_squeeze(&st->iosha, out,
+                  nblocks * STREAM256_BLOCKBYTES);
+#else
+    iosha_squeezeblocks(out, nblocks, &st->iosha); /* 64-byte blocks */
+#endif
+}
+
+/* ---------------- 4-way 128-bit stream -------------------------------- */
+/* Four stream128 instances on the multi-buffer permutation; lane j is
+   bit-identical to iosha_stream128_init(seed, nonce[j]) and its blocks. */
+static void iosha_stream128x4_init(stream_x4_state *st,
+                                   const uint8_t seed[SEEDBYTES],
+                                   const uint16_t nonce[4])
+{
+    iosha_ctx_x4 *ctx = &st->iosha;
+    uint8_t t[4][2];
+
+    for (int j = 0; j < 4; ++j) {
+        t[j][0] = (uint8_t)nonce[j];
+        t[j][1] = (uint8_t)(nonce[j] >> 8);
+    }
+
+    iosha_init_128_x4(ctx, 0x01);
+    iosha_absorb_x4(ctx, seed, seed, seed, seed, SEEDBYTES);
+    iosha_absorb_x4(ctx, t[0], t[1], t[2], t[3], 2);
+#if IOSHA_XOF_VERSION != 1
+    iosha_finalize_x4(ctx);
+#endif
+}
+
+static void iosha_stream128x4_squeezeblocks(uint8_t *const out[4],
+                                            size_t         nblocks,
+                                            stream_x4_state *st)
+{
+#if IOSHA_XOF_VERSION == 1
+    iosha_squeeze_x4(&st->iosha, out[0], out[1], out[2], out[3],
+                     nblocks * STREAM128_BLOCKBYTES);
+#else
+    iosha_squeezeblocks_x4(out[0], out[1], out[2], out[3], nblocks,
+                           &st->iosha);
+#endif
+}
+
+/* ---------------- 4-way 256-bit stream -------------------------------- */
+static void iosha_stream256x4_init(stream_x4_state *st,
+                                   const uint8_t seed[CRHBYTES],
+                                   const uint16_t nonce[4])
+{
+    iosha_ctx_x4 *ctx = &st->iosha;
+    uint8_t t[4][2];
+
+    for (int j = 0; j < 4; ++j) {
+        t[j][0] = (uint8_t)nonce[j];
+        t[j][1] = (uint8_t)(nonce[j] >> 8);
+    }
+
+    iosha_init_x4(ctx, 0x01);
+    iosha_absorb_x4(ctx, seed, seed, seed, seed, CRHBYTES);
+    iosha_absorb_x4(ctx, t[0], t[1], t[2], t[3], 2);
+#if IOSHA_XOF_VERSION != 1
+    iosha_finalize_x4(ctx);
+#endif
+}
+
+static void iosha_stream256x4_squeezeblocks(uint8_t *const out[4],
+                                            size_t         nblocks,
+                                            stream_x4_state *st)
+{
+#if IOSHA_XOF_VERSION == 1
+    iosha_squeeze_x4(&st->iosha, out[0], out[1], out[2], out[3],
+                     nblocks * STREAM256_BLOCKBYTES);
+#else
+    iosha_squeezeblocks_x4(out[0], out[1], out[2], out[3], nblocks,
+                           &st->iosha);
+#endif
+}
+
+/* ---------------- 8-way 128-bit stream -------------------------------- */
+/* Eight stream128 instances for ExpandA on AVX-512 hosts */
+static void iosha_stream128x8_init(stream_x8_state *st,
+                                   const uint8_t seed[SEEDBYTES],
+                                   const uint16_t nonce[8])
+{
+    iosha_ctx_x8 *ctx = &st->iosha;
+    uint8_t t[8][2];
+
+    for (int j = 0; j < 8; ++j) {
+        t[j][0] = (uint8_t)nonce[j];
+        t[j][1] = (uint8_t)(nonce[j] >> 8);
+    }
+
+    iosha_init_128_x8(ctx, 0x01);
+    iosha_absorb_x8(ctx, seed, seed, seed, seed, seed, seed, seed, seed,
+                    SEEDBYTES);
+    iosha_absorb_x8(ctx, t[0], t[1], t[2], t[3], t[4], t[5], t[6], t[7], 2);
+#if IOSHA_XOF_VERSION != 1
+    iosha_finalize_x8(ctx);
+#endif
+}
+
+static void iosha_stream128x8_squeezeblocks(uint8_t *const out[8],
+                                            size_t         nblocks,
+                                            stream_x8_state *st)
+{
+#if IOSHA_XOF_VERSION == 1
+    iosha_squeeze_x8(&st->iosha, out[0], out[1], out[2], out[3],
+                     out[4], out[5], out[6], out[7],
+                     nblocks * STREAM128_BLOCKBYTES);
+#else
+    iosha_squeezeblocks_x8(out[0], out[1], out[2], out[3],
+                           out[4], out[5], out[6], out[7], nblocks,
+                           &st->iosha);
+#endif
+}
+
+/* ---------------- in-place squeeze ----------------------------------- */
+/* v2 output blocks are the rate lanes right after each permutation, so
+   the samplers can parse them where they are. v1 re-pads on every
+   squeeze and keeps going through iosha_squeeze*. */
+#if IOSHA_XOF_VERSION != 1
+static const uint64_t *iosha_stream128_squeezelanes(stream128_state *st)
+{
+    iosha_permute(st->iosha.st);
+    st->iosha.idx = st->iosha.rate;
+    return st->iosha.st;
+}
+
+static const uint64_t *iosha_stream256_squeezelanes(stream256_state *st)
+{
+    iosha_permute(st->iosha.st);
+    st->iosha.idx = st->iosha.rate;
+    return st->iosha.st;
+}
+#else
+#define iosha_stream128_squeezelanes NULL
+#define iosha_stream256_squeezelanes NULL
+#endif
+
+const dilithium_symmetric dilithium_symmetric_iosha = {
+    "IOSHA",
+    iosha_crh_init,
+    iosha_crh_absorb,
+    iosha_crh_squeeze,
+    iosha_stream128_init,
+    iosha_stream128_squeezeblocks,
+    iosha_stream256_init,
+    iosha_stream256_squeezeblocks,
+    STREAM128_BLOCKBYTES,
+    iosha_stream128x4_init,
+    iosha_stream128x4_squeezeblocks,
+    STREAM256_BLOCKBYTES,
+    iosha_stream256x4_init,
+    iosha_stream256x4_squeezeblocks,
+    iosha_stream128_squeezelanes,
+    iosha_stream256_squeezelanes,
+    iosha_stream128x8_init,
+    iosha_stream128x8_squeezeblocks
+};
@@ -1,54 +1,145 @@
-/*  iosha_stream.c  –  SHAKE-compatible stream helpers powered by IOSHA-v2  */
-#include <string.h>
-#include "symmetric.h"     /* pulls in params.h, iosha.h, fips202.h */
+#include <stdint.h>
+#include "params.h"
+#include "symmetric.h"
+#include "fips202.h"
+#include "fips202x4.h"
 
-/* ---------- Helper: reinterpret keccak_state buffer as iosha_ctx ------ */
-/* keccak_state is 25×64-bit = 200 bytes.  iosha_ctx is 8×64 + idx = 72 B.
-   So we can safely overlay an iosha_ctx on top of the keccak_state memory. */
-static inline iosha_ctx *as_iosha(keccak_state *st)
+/* Genuine SHAKE backend: CRH is SHAKE256, the 128/256-bit streams are
+   SHAKE128/SHAKE256(seed || nonce). The samplers ask for
+   STREAM*_BLOCKBYTES-sized blocks, which need not match the Keccak rate;
+   shake*_squeeze keeps the output a single byte stream regardless. */
+
+static void shake_crh_init(crh_state *st)
+{
+  shake256_init(&st->s.keccak);
+  st->squeezing = 0;
+}
+
+static void shake_crh_absorb(crh_state *st, const uint8_t *in, size_t inlen)
+{
+  shake256_absorb(&st->s.keccak, in, inlen);
+}
+
+static void shake_crh_squeeze(crh_state *st, uint8_t *out, size_t outlen)
+{
+  if(!st->squeezing) {
+    shake256_finalize(&st->s.keccak);
+    st->squeezing = 1;
+  }
+  shake256_squeeze(out, outlen, &st->s.keccak);
+}
+
+static void shake_stream128_init(stream128_state *state,
+                                 const uint8_t seed[SEEDBYTES],
+                                 uint16_t nonce)
+{
+  uint8_t t[2];
+  t[0] = nonce;
+  t[1] = nonce >> 8;
+
+  shake128_init(&state->keccak);
+  shake128_absorb(&state->keccak, seed, SEEDBYTES);
+  shake128_absorb(&state->keccak, t, 2);
+  shake128_finalize(&state->keccak);
+}
+
+static void shake_stream128_squeezeblocks(uint8_t *out,
+                                          size_t nblocks,
+                                          stream128_state *state)
+{
+  shake128_squeeze(out, nblocks*STREAM128_BLOCKBYTES, &state->keccak);
+}
+
+static void shake_stream256_init(stream256_state *state,
+                                 const uint8_t seed[CRHBYTES],
+                                 uint16_t nonce)
+{
+  uint8_t t[2];
+  t[0] = nonce;
+  t[1] = nonce >> 8;
+
+  shake256_init(&state->keccak);
+  shake256_absorb(&state->keccak, seed, CRHBYTES);
+  shake256_absorb(&state->keccak, t, 2);
+  shake256_finalize(&state->keccak);
+}
+
+static void shake_stream256_squeezeblocks(uint8_t *out,
+                                          size_t nblocks,
+                                          stream256_state *state)
 {
-    return (iosha_ctx *)st;      /* aliasing OK on all modern compilers   */
+  shake256_squeeze(out, nblocks*STREAM256_BLOCKBYTES, &state->keccak);
 }
 
-/* ---------------- 128-bit security stream (was SHAKE-128) ------------- */
-void dilithium_shake128_stream_init(keccak_state *st,
-                                    const uint8_t seed[SEEDBYTES],
-                                    uint16_t      nonce)
+static void shake_stream128x4_init(stream_x4_state *state,
+                                   const uint8_t seed[SEEDBYTES],
+                                   const uint16_t nonce[4])
 {
-    iosha_ctx *ctx = as_iosha(st);
-    iosha_init_128(ctx, 0x01);                       /* domain tag 0x01 = XOF */
+  unsigned int i, j;
+  uint8_t in[4][SEEDBYTES + 2];
 
-    uint8_t t[2] = { (uint8_t)nonce, (uint8_t)(nonce >> 8) };
-    iosha_absorb_128(ctx, seed, SEEDBYTES);          /* absorb seed */
-    iosha_absorb_128(ctx, t, 2);                     /* absorb nonce */
-    /* NOTE: no finalise needed – iosha_absorb contains the permute logic */
+  for(j = 0; j < 4; ++j) {
+    for(i = 0; i < SEEDBYTES; ++i)
+      in[j][i] = seed[i];
+    in[j][SEEDBYTES+0] = nonce[j];
+    in[j][SEEDBYTES+1] = nonce[j] >> 8;
+  }
+
+  shake128x4_absorb_once(&state->keccak, in[0], in[1], in[2], in[3],
+                         SEEDBYTES + 2);
 }
 
-void stream128_squeezeblocks(uint8_t       *out,
-                             size_t         nblocks,
-                             stream128_state *st)
+static void shake_stream128x4_squeezeblocks(uint8_t *const out[4],
+                                            size_t nblocks,
+                                            stream_x4_state *state)
 {
-    iosha_squeeze_128(as_iosha(st), out,
-                  nblocks * STREAM128_BLOCKBYTES);   /* 32-byte blocks */
+  shake128x4_squeezeblocks(out[0], out[1], out[2], out[3], nblocks,
+                           &state->keccak);
 }
 
-/* ---------------- 256-bit security stream (was SHAKE-256) ------------- */
-void dilithium_shake256_stream_init(keccak_state *st,
-                                    const uint8_t seed[CRHBYTES],
-                                    uint16_t      nonce)
+static void shake_stream256x4_init(stream_x4_state *state,
+                                   const uint8_t seed[CRHBYTES],
+                                   const uint16_t nonce[4])
 {
-    iosha_ctx *ctx = as_iosha(st);
-    iosha_init(ctx, 0x01);                       /* same XOF tag */
+  unsigned int i, j;
+  uint8_t in[4][CRHBYTES + 2];
+
+  for(j = 0; j < 4; ++j) {
+    for(i = 0; i < CRHBYTES; ++i)
+      in[j][i] = seed[i];
+    in[j][CRHBYTES+0] = nonce[j];
+    in[j][CRHBYTES+1] = nonce[j] >> 8;
+  }
 
-    uint8_t t[2] = { (uint8_t)nonce, (uint8_t)(nonce >> 8) };
-    iosha_absorb(ctx, seed, CRHBYTES);
-    iosha_absorb(ctx, t, 2);
+  shake256x4_absorb_once(&state->keccak, in[0], in[1], in[2], in[3],
+                         CRHBYTES + 2);
 }
 
-void stream256_squeezeblocks(uint8_t       *out,
-                             size_t         nblocks,
-                             stream256_state *st)
+static void shake_stream256x4_squeezeblocks(uint8_t *const out[4],
+                                            size_t nblocks,
+                                            stream_x4_state *state)
 {
-    iosha_squeeze(as_iosha(st), out,
-                  nblocks * STREAM256_BLOCKBYTES);
+  shake256x4_squeezeblocks(out[0], out[1], out[2], out[3], nblocks,
+                           &state->keccak);
 }
+
+const dilithium_symmetric dilithium_symmetric_shake = {
+  "SHAKE",
+  shake_crh_init,
+  shake_crh_absorb,
+  shake_crh_squeeze,
+  shake_stream128_init,
+  shake_stream128_squeezeblocks,
+  shake_stream256_init,
+  shake_stream256_squeezeblocks,
+  SHAKE128_RATE,
+  shake_stream128x4_init,
+  shake_stream128x4_squeezeblocks,
+  SHAKE256_RATE,
+  shake_stream256x4_init,
+  shake_stream256x4_squeezeblocks,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
@@ -3,37 +3,123 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "config.h"
 #include "params.h"
 #include "fips202.h"           /* for original keccak_state struct   */
+#include "fips202x4.h"
 #include "iosha.h"
 
-/* ---------------- stream-state aliases --------------------------- */
-typedef keccak_state stream128_state;   /* unchanged struct          */
-typedef keccak_state stream256_state;
+/* ---------------- stream states ----------------------------------- */
+/* Either backend's sponge; each backend only touches its own member */
+typedef union {
+  iosha_ctx iosha;
+  keccak_state keccak;
+} stream_state;
 
-/* 32-byte rate equals 256-bit capacity                              */
+typedef stream_state stream128_state;
+typedef stream_state stream256_state;
+
+/* Four streams of one backend squeezed in lockstep */
+typedef union {
+  iosha_ctx_x4 iosha;
+  keccakx4_state keccak;
+} stream_x4_state;
+
+/* Eight streams in lockstep; only IOSHA has an 8-way engine */
+typedef union {
+  iosha_ctx_x8 iosha;
+} stream_x8_state;
+
+/* Block sizes the samplers work in. Both backends squeeze byte streams,
+   so SHAKE output does not depend on them; they follow the IOSHA rate. */
+#if IOSHA_XOF_VERSION == 1
+/* legacy: 32-byte blocks, every squeeze call re-pads                */
 #define STREAM128_BLOCKBYTES 32
 #define STREAM256_BLOCKBYTES 32
+#else
+/* one block per permutation: the full sponge rate                   */
+#define STREAM128_BLOCKBYTES 96
+#define STREAM256_BLOCKBYTES 64
+#endif
+
+/* ---------------- CRH (H in the spec) ----------------------------- */
+/* Incremental hash state of either backend; copy it to fork a prefix */
+typedef struct {
+  union {
+    iosha_ctx iosha;
+    keccak_state keccak;
+  } s;
+  unsigned int squeezing;   /* SHAKE: finalized on the first squeeze */
+} crh_state;
+
+/* ---------------- backend vtable ---------------------------------- */
+/* All hashing of the Dilithium pipeline goes through one of these; the
+   backend is picked when a key pair or signing/verification context is
+   created, so IOSHA and SHAKE can run side by side in one process. */
+typedef struct dilithium_symmetric {
+  const char *name;
 
-/* ---------- API (names stay identical to SHAKE version) ---------- */
-void dilithium_shake128_stream_init(keccak_state       *st,
-                                    const uint8_t      seed[SEEDBYTES],
-                                    uint16_t           nonce);
+  void (*crh_init)(crh_state *st);
+  void (*crh_absorb)(crh_state *st, const uint8_t *in, size_t inlen);
+  void (*crh_squeeze)(crh_state *st, uint8_t *out, size_t outlen);
 
-void dilithium_shake256_stream_init(keccak_state       *st,
-                                    const uint8_t      seed[CRHBYTES],
-                                    uint16_t           nonce);
+  void (*stream128_init)(stream128_state *st,
+                         const uint8_t seed[SEEDBYTES], uint16_t nonce);
+  void (*stream128_squeezeblocks)(uint8_t *out, size_t nblocks,
+                                  stream128_state *st);
+  void (*stream256_init)(stream256_state *st,
+                         const uint8_t seed[CRHBYTES], uint16_t nonce);
+  void (*stream256_squeezeblocks)(uint8_t *out, size_t nblocks,
+                                  stream256_state *st);
 
-void stream128_squeezeblocks(uint8_t *out, size_t nblocks,
-                             stream128_state *st);
+  /* Optional 4-way streams, NULL when the backend has none; lane j is
+     the same byte stream as the single stream with nonce[j], handed out
+     in blocks of stream*x4_blockbytes (at most STREAMX4_MAXBLOCKBYTES). */
+  unsigned int stream128x4_blockbytes;
+  void (*stream128x4_init)(stream_x4_state *st,
+                           const uint8_t seed[SEEDBYTES],
+                           const uint16_t nonce[4]);
+  void (*stream128x4_squeezeblocks)(uint8_t *const out[4], size_t nblocks,
+                                    stream_x4_state *st);
+  unsigned int stream256x4_blockbytes;
+  void (*stream256x4_init)(stream_x4_state *st,
+                           const uint8_t seed[CRHBYTES],
+                           const uint16_t nonce[4]);
+  void (*stream256x4_squeezeblocks)(uint8_t *const out[4], size_t nblocks,
+                                    stream_x4_state *st);
 
-void stream256_squeezeblocks(uint8_t *out, size_t nblocks,
-                             stream256_state *st);
+  /* Optional in-place squeeze, NULL when the backend has none: permutes
+     and returns the next STREAM*_BLOCKBYTES of the stream as the sponge's
+     own rate lanes, valid until the next call on the same state. The
+     block sequence is the one stream*_squeezeblocks hands out. */
+  const uint64_t *(*stream128_squeezelanes)(stream128_state *st);
+  const uint64_t *(*stream256_squeezelanes)(stream256_state *st);
 
-/* ---------- macro wrappers used by other modules ---------------- */
-#define stream128_init(STATE,SEED,NONCE) \
-        dilithium_shake128_stream_init(STATE,SEED,NONCE)
-#define stream256_init(STATE,SEED,NONCE) \
-        dilithium_shake256_stream_init(STATE,SEED,NONCE)
+  /* Optional 8-way 128-bit stream, NULL when the backend has none; lane
+     j is the same byte stream as stream128 with nonce[j], handed out in
+     STREAM128_BLOCKBYTES blocks. */
+  void (*stream128x8_init)(stream_x8_state *st,
+                           const uint8_t seed[SEEDBYTES],
+                           const uint16_t nonce[8]);
+  void (*stream128x8_squeezeblocks)(uint8_t *const out[8], size_t nblocks,
+                                    stream_x8_state *st);
+} dilithium_symmetric;
+
+#define STREAMX4_MAXBLOCKBYTES SHAKE128_RATE
+
+/* IOSHA-v2 (symmetric-iosha.c) */
+#define dilithium_symmetric_iosha DILITHIUM_NAMESPACE(symmetric_iosha)
+extern const dilithium_symmetric dilithium_symmetric_iosha;
+
+/* SHAKE128/SHAKE256 from fips202.c (symmetric-shake.c) */
+#define dilithium_symmetric_shake DILITHIUM_NAMESPACE(symmetric_shake)
+extern const dilithium_symmetric dilithium_symmetric_shake;
+
+/* Backend used by the plain crypto_sign_* API and for NULL arguments */
+#ifdef DILITHIUM_USE_SHAKE
+#define dilithium_symmetric_default dilithium_symmetric_shake
+#else
+#define dilithium_symmetric_default dilithium_symmetric_iosha
+#endif
 
 #endif
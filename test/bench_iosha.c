@@ -0,0 +1,203 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "../iosha.h"
+#include "../fips202.h"
+#include "../fips202x4.h"
+#include "cpucycles.h"
+#include "iosha_bytewise.h"
+
+#define NTESTS 1000
+#define NPERM 64   /* permutations per timed call in the permutation bench */
+
+#define MINLEN (1 << 10)
+#define MAXLEN (1 << 26)
+#define MAXOUT (1 << 16)
+
+static uint64_t t[NTESTS];
+static uint64_t st[8*16];
+static uint64_t overhead;
+
+static int cmp_uint64(const void *a, const void *b) {
+  if(*(uint64_t *)a < *(uint64_t *)b) return -1;
+  if(*(uint64_t *)a > *(uint64_t *)b) return 1;
+  return 0;
+}
+
+static uint64_t median(size_t n) {
+  qsort(t, n, sizeof(uint64_t), cmp_uint64);
+  return t[n/2];
+}
+
+/* Median cycles of one timed call, divided by the bytes it processed */
+static void print_cpb_n(const char *s, size_t bytes, size_t n) {
+  uint64_t med = median(n);
+
+  printf("%-32s %10llu cycles  %8.2f cycles/byte\n", s,
+         (unsigned long long)med, (double)med/bytes);
+}
+
+/* Median cycles of one timed call covering ops operations */
+static void print_cpo(const char *s, size_t ops, size_t n) {
+  printf("%-32s %10.1f cycles/call\n", s, (double)median(n)/ops);
+}
+
+#define TIME(n, init, call) do {                \
+    unsigned int i_;                            \
+    uint64_t t0_;                               \
+    for(i_ = 0; i_ < (n); ++i_) {               \
+      init;                                     \
+      t0_ = cpucycles();                        \
+      call;                                     \
+      t[i_] = cpucycles() - t0_ - overhead;     \
+    }                                           \
+  } while(0)
+
+static void bench_permute(uint8_t *buf)
+{
+  unsigned int j;
+  iosha_ctx ctx;
+  keccak_state ks;
+  keccakx4_state ks4;
+
+  TIME(NTESTS, , for(j = 0; j < NPERM; ++j) iosha_permute(st));
+  print_cpo("iosha_permute:", NPERM, NTESTS);
+  TIME(NTESTS, , for(j = 0; j < NPERM; ++j) iosha_permute_x4(st));
+  print_cpo("iosha_permute_x4 (per state):", 4*NPERM, NTESTS);
+  TIME(NTESTS, , for(j = 0; j < NPERM; ++j) iosha_permute_x8(st));
+  print_cpo("iosha_permute_x8 (per state):", 8*NPERM, NTESTS);
+
+  /* One block = one permutation plus the rate-sized copy */
+  iosha_init(&ctx, 0x01);
+  iosha_finalize(&ctx);
+  TIME(NTESTS, , iosha_squeezeblocks(buf, NPERM, &ctx));
+  print_cpo("iosha_squeezeblocks (64 B):", NPERM, NTESTS);
+  iosha_init_128(&ctx, 0x01);
+  iosha_finalize(&ctx);
+  TIME(NTESTS, , iosha_squeezeblocks(buf, NPERM, &ctx));
+  print_cpo("iosha_squeezeblocks (96 B):", NPERM, NTESTS);
+
+  shake256_init(&ks);
+  shake256_finalize(&ks);
+  TIME(NTESTS, , shake256_squeezeblocks(buf, NPERM, &ks));
+  print_cpo("shake256_squeezeblocks (136 B):", NPERM, NTESTS);
+  shake128_init(&ks);
+  shake128_finalize(&ks);
+  TIME(NTESTS, , shake128_squeezeblocks(buf, NPERM, &ks));
+  print_cpo("shake128_squeezeblocks (168 B):", NPERM, NTESTS);
+  shake128x4_absorb_once(&ks4, buf, buf, buf, buf, 0);
+  TIME(NTESTS, , shake128x4_squeezeblocks(buf, buf, buf, buf, NPERM/4, &ks4));
+  print_cpo("shake128x4_squeezeblocks (x4):", NPERM, NTESTS);
+  printf("\n");
+}
+
+static void bench_absorb(const uint8_t *m)
+{
+  unsigned int n;
+  size_t len;
+  char name[64];
+  uint8_t out[64];
+  iosha_ctx ctx;
+  keccak_state ks;
+
+  for(len = MINLEN; len <= MAXLEN; len <<= 2) {
+    n = (len >= (1 << 20)) ? 5 : NTESTS;
+
+    TIME(n, iosha_init(&ctx, 0x02), absorb_bytewise(&ctx, m, len));
+    snprintf(name, sizeof(name), "absorb bytewise %zuK:", len >> 10);
+    print_cpb_n(name, len, n);
+
+    TIME(n, iosha_init(&ctx, 0x02), iosha_absorb(&ctx, m, len));
+    snprintf(name, sizeof(name), "iosha_absorb %zuK:", len >> 10);
+    print_cpb_n(name, len, n);
+
+    TIME(n, , iosha_tree_bytes(m, len, out, sizeof(out)));
+    snprintf(name, sizeof(name), "iosha_tree_bytes %zuK:", len >> 10);
+    print_cpb_n(name, len, n);
+
+    TIME(n, shake256_init(&ks), shake256_absorb(&ks, m, len));
+    snprintf(name, sizeof(name), "shake256_absorb %zuK:", len >> 10);
+    print_cpb_n(name, len, n);
+
+    TIME(n, shake128_init(&ks), shake128_absorb(&ks, m, len));
+    snprintf(name, sizeof(name), "shake128_absorb %zuK:", len >> 10);
+    print_cpb_n(name, len, n);
+    printf("\n");
+  }
+}
+
+static void bench_squeeze(uint8_t *buf)
+{
+  size_t len;
+  char name[64];
+  iosha_ctx ctx;
+  keccak_state ks;
+
+  for(len = 32; len <= MAXOUT; len <<= 2) {
+    TIME(NTESTS, iosha_init(&ctx, 0x01), iosha_squeeze(&ctx, buf, len));
+    snprintf(name, sizeof(name), "iosha_squeeze %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+
+    TIME(NTESTS, (iosha_init(&ctx, 0x01), iosha_finalize(&ctx)),
+         iosha_squeezeblocks(buf, (len + 63)/64, &ctx));
+    snprintf(name, sizeof(name), "iosha_squeezeblocks %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+
+    TIME(NTESTS, (shake256_init(&ks), shake256_finalize(&ks)),
+         shake256_squeeze(buf, len, &ks));
+    snprintf(name, sizeof(name), "shake256_squeeze %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+    printf("\n");
+  }
+}
+
+/* The one-shot wrappers as Dilithium uses them: a 32-byte seed expanded
+   to outlen bytes, and a variable-length input hashed to 64 bytes */
+static void bench_oneshot(const uint8_t *m, uint8_t *buf)
+{
+  size_t len;
+  char name[64];
+
+  for(len = 32; len <= MAXOUT; len <<= 2) {
+    TIME(NTESTS, , iosha_xof_bytes(m, 32, 0, buf, len));
+    snprintf(name, sizeof(name), "iosha_xof_bytes %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+
+    TIME(NTESTS, , shake128(buf, len, m, 34));
+    snprintf(name, sizeof(name), "shake128 %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+  }
+  printf("\n");
+
+  for(len = 32; len <= MAXOUT; len <<= 2) {
+    TIME(NTESTS, , iosha_crh_bytes(m, len, buf, 64));
+    snprintf(name, sizeof(name), "iosha_crh_bytes %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+
+    TIME(NTESTS, , shake256(buf, 64, m, len));
+    snprintf(name, sizeof(name), "shake256 %zu:", len);
+    print_cpb_n(name, len, NTESTS);
+  }
+  printf("\n");
+}
+
+int main(void)
+{
+  uint8_t *m, *buf;
+
+  overhead = cpucycles_overhead();
+  m = (uint8_t *)calloc(MAXLEN, 1);
+  buf = (uint8_t *)malloc(MAXOUT + NPERM*SHAKE128_RATE);
+  if(!m || !buf)
+    return -1;
+
+  bench_permute(buf);
+  bench_oneshot(m, buf);
+  bench_squeeze(buf);
+  bench_absorb(m);
+
+  free(buf);
+  free(m);
+  return 0;
+}
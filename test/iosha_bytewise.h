@@ -0,0 +1,25 @@
+#ifndef IOSHA_BYTEWISE_H
+#define IOSHA_BYTEWISE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../iosha.h"
+
+/* Byte-at-a-time absorb, as the sponge did before the word-wise path.
+   test_iosha checks iosha_absorb against it, bench_iosha times it as the
+   baseline. */
+static void absorb_bytewise(iosha_ctx *ctx, const uint8_t *in, size_t inlen)
+{
+  size_t i;
+  uint8_t *b = (uint8_t *)ctx->st;
+
+  for(i = 0; i < inlen; ++i) {
+    b[ctx->idx++] ^= in[i];
+    if(ctx->idx == ctx->rate) {
+      iosha_permute(ctx->st);
+      ctx->idx = 0;
+    }
+  }
+}
+
+#endif
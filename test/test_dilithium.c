@@ -3,11 +3,155 @@
 #include <stdio.h>
 #include "../randombytes.h"
 #include "../sign.h"
+#include "../poly.h"
+#include "../polyvec.h"
+#include "../sparse.h"
+#include "../rejsample.h"
 
 #define MLEN 59
 #define CTXLEN 14
 #define NTESTS 10000
 
+static matcache_entry cache_mem[2];
+
+static int poly_equal(const poly *a, const poly *b)
+{
+  unsigned int i;
+
+  for(i = 0; i < N; ++i)
+    if(a->coeffs[i] != b->coeffs[i])
+      return 0;
+  return 1;
+}
+
+/* The 4- and 8-way samplers must give what the single-stream ones give */
+static int check_x4(const dilithium_symmetric *sym)
+{
+  unsigned int j;
+  uint16_t nonce, n8[8];
+  uint8_t seed[CRHBYTES];
+  poly a[8], b;
+  poly *p8[8];
+
+  randombytes(seed, CRHBYTES);
+  randombytes((uint8_t *)&nonce, sizeof(nonce));
+
+  if(sym->stream128x8_init) {
+    for(j = 0; j < 8; ++j) {
+      p8[j] = &a[j];
+      n8[j] = nonce + j;
+    }
+    poly_uniform_8x(p8, seed, n8, sym);
+    for(j = 0; j < 8; ++j) {
+      poly_uniform(&b, seed, nonce + j, sym);
+      if(!poly_equal(&a[j], &b))
+        return -1;
+    }
+  }
+
+  if(sym->stream128x4_init) {
+    poly_uniform_4x(&a[0], &a[1], &a[2], &a[3], seed,
+                    nonce, nonce + 1, nonce + 2, nonce + 3, sym);
+    for(j = 0; j < 4; ++j) {
+      poly_uniform(&b, seed, nonce + j, sym);
+      if(!poly_equal(&a[j], &b))
+        return -1;
+    }
+  }
+
+  if(!sym->stream256x4_init)
+    return 0;
+
+  poly_uniform_eta_4x(&a[0], &a[1], &a[2], &a[3], seed,
+                      nonce, nonce + 1, nonce + 2, nonce + 3, sym);
+  for(j = 0; j < 4; ++j) {
+    poly_uniform_eta(&b, seed, nonce + j, sym);
+    if(!poly_equal(&a[j], &b))
+      return -1;
+  }
+
+  poly_uniform_gamma1_4x(&a[0], &a[1], &a[2], &a[3], seed,
+                         nonce, nonce + 1, nonce + 2, nonce + 3, sym);
+  for(j = 0; j < 4; ++j) {
+    poly_uniform_gamma1(&b, seed, nonce + j, sym);
+    if(!poly_equal(&a[j], &b))
+      return -1;
+  }
+
+  return 0;
+}
+
+/* The vectorised rejection samplers must give what the scalar ones give */
+static int check_rej(void)
+{
+  unsigned int i, len, n0, n1;
+  uint8_t buf[5*168];
+  int32_t a[N], b[N];
+
+  /* Reject about a quarter of the candidates so every lane mask shows up */
+  randombytes(buf, sizeof(buf));
+  for(i = 0; i < sizeof(buf)/3; ++i) {
+    if(!(buf[3*i] & 3)) {
+      buf[3*i+1] = 0xFF;
+      buf[3*i+2] = 0xFF;
+    }
+  }
+  randombytes((uint8_t *)&len, sizeof(len));
+  len %= N + 1;
+
+  n0 = rej_uniform(a, len, buf, sizeof(buf));
+  n1 = rej_uniform_ref(b, len, buf, sizeof(buf));
+  if(n0 != n1)
+    return -1;
+  for(i = 0; i < n0; ++i)
+    if(a[i] != b[i])
+      return -1;
+
+  n0 = rej_eta(a, len, buf, sizeof(buf));
+  n1 = rej_eta_ref(b, len, buf, sizeof(buf));
+  if(n0 != n1)
+    return -1;
+  for(i = 0; i < n0; ++i)
+    if(a[i] != b[i])
+      return -1;
+
+  return 0;
+}
+
+/* The sparse challenge product must agree with the NTT one mod Q */
+static int check_sparse(void)
+{
+  unsigned int i;
+  uint8_t seed[CRHBYTES];
+  poly cp, a, b;
+  poly_sparse c;
+
+  randombytes(seed, CRHBYTES);
+  poly_challenge(&cp, seed, &dilithium_symmetric_default);
+  poly_uniform_eta(&a, seed, 0, &dilithium_symmetric_default);
+
+  poly_sparse_from_challenge(&c, &cp);
+  poly_sparse_mul(&b, &c, &a);
+
+  poly_ntt(&cp);
+  poly_ntt(&a);
+  poly_pointwise_montgomery(&a, &cp, &a);
+  poly_invntt_tomont(&a);
+  poly_sub(&a, &a, &b);
+  for(i = 0; i < N; ++i)
+    if(a.coeffs[i] % Q)
+      return -1;
+
+  /* So must the table-driven NTT of c */
+  poly_sparse_ntt(&b, &c);
+  poly_sub(&b, &b, &cp);
+  for(i = 0; i < N; ++i)
+    if(b.coeffs[i] % Q)
+      return -1;
+
+  return 0;
+}
+
 int main(void)
 {
   size_t i, j;
@@ -20,14 +164,137 @@ int main(void)
   uint8_t sm[MLEN + CRYPTO_BYTES];
   uint8_t pk[CRYPTO_PUBLICKEYBYTES];
   uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t pk2[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk2[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t sig2[CRYPTO_BYTES];
+  uint8_t rnd[RNDBYTES];
+  size_t siglen;
+  dilithium_signing_key ssk;
+  dilithium_sign_ctx sst;
+  dilithium_verify_ctx vst;
+  randombytes_rng rng;
+  randombytes_det_state det;
+  dilithium_matrix_cache cache;
+  dilithium_public_key key;
+  unsigned long long hits;
+  const dilithium_symmetric *other = &dilithium_symmetric_shake;
+
+  if(other == &dilithium_symmetric_default)
+    other = &dilithium_symmetric_iosha;
 
   snprintf((char*)ctx,CTXLEN,"test_dilitium");
+  matrix_cache_init(&cache, cache_mem, sizeof(cache_mem));
 
   for(i = 0; i < NTESTS; ++i) {
+    if(check_x4(&dilithium_symmetric_iosha) || check_x4(&dilithium_symmetric_shake)) {
+      fprintf(stderr, "Multi-way samplers differ from single-stream sampling\n");
+      return -1;
+    }
+
+    if(check_sparse()) {
+      fprintf(stderr, "Sparse challenge product differs from NTT product\n");
+      return -1;
+    }
+
+    if(check_rej()) {
+      fprintf(stderr, "Vectorised rejection sampling differs from scalar\n");
+      return -1;
+    }
+
     randombytes(m, MLEN);
 
     crypto_sign_keypair(pk, sk);
     crypto_sign(sm, &smlen, m, MLEN, ctx, CTXLEN, sk);
+
+    /* Signing from a prepared context must match the one-shot path */
+    randombytes(rnd, RNDBYTES);
+    crypto_sign_signing_key_init(&ssk, sk, NULL, NULL);
+    crypto_sign_signature_internal(sig, &siglen, m, MLEN, ctx, CTXLEN, rnd, sk);
+    crypto_sign_signature_key_internal(sig2, &siglen, m, MLEN, ctx, CTXLEN, rnd, &ssk);
+    for(j = 0; j < CRYPTO_BYTES; ++j) {
+      if(sig[j] != sig2[j]) {
+        fprintf(stderr, "Signing context gives a different signature\n");
+        return -1;
+      }
+    }
+
+    /* A deterministic source replays the same key and signature, the
+       second time through a streaming context on the prepared key */
+    randombytes(rnd, RNDBYTES);
+    for(j = 0; j < 2; ++j) {
+      randombytes_det_init(&rng, &det, rnd, RNDBYTES);
+      crypto_sign_keypair_rng(pk2, sk2, NULL, &rng);
+      crypto_sign_signing_key_init(&ssk, sk2, NULL, &rng);
+      if(!j) {
+        crypto_sign_signature_key(sig, &siglen, m, MLEN, ctx, CTXLEN, &ssk);
+        continue;
+      }
+      crypto_sign_init_key(&sst, ctx, CTXLEN, &ssk);
+      crypto_sign_update(&sst, m, MLEN);
+      crypto_sign_final(&sst, sig2, &siglen);
+    }
+    for(j = 0; j < CRYPTO_BYTES; ++j) {
+      if(sig[j] != sig2[j]) {
+        fprintf(stderr, "Deterministic source does not replay\n");
+        return -1;
+      }
+    }
+
+    /* Streaming sign and verify, message split at a random point */
+    randombytes(&b, 1);
+    b %= MLEN + 1;
+    crypto_sign_init(&sst, ctx, CTXLEN, sk, NULL);
+    crypto_sign_update(&sst, m, b);
+    crypto_sign_update(&sst, m + b, MLEN - b);
+    crypto_sign_final(&sst, sig, &siglen);
+    if(crypto_sign_verify(sig, siglen, m, MLEN, ctx, CTXLEN, pk)) {
+      fprintf(stderr, "Streaming signature does not verify\n");
+      return -1;
+    }
+    crypto_sign_verify_init(&vst, ctx, CTXLEN, pk, NULL);
+    crypto_sign_verify_update(&vst, m, MLEN - b);
+    crypto_sign_verify_update(&vst, m + MLEN - b, b);
+    if(crypto_sign_verify_final(&vst, sm, CRYPTO_BYTES)) {
+      fprintf(stderr, "Streaming verification failed\n");
+      return -1;
+    }
+
+    /* A prepared key verifies the same; the second time A is cached */
+    crypto_sign_public_key_init(&key, pk, NULL, &cache);
+    hits = cache.hits;
+    if(crypto_sign_verify_key(sm, CRYPTO_BYTES, m, MLEN, ctx, CTXLEN, &key) ||
+       crypto_sign_verify_key(sm, CRYPTO_BYTES, m, MLEN, ctx, CTXLEN, &key)) {
+      fprintf(stderr, "Prepared key verification failed\n");
+      return -1;
+    }
+    if(cache.hits != hits + 1) {
+      fprintf(stderr, "Matrix cache missed a known key\n");
+      return -1;
+    }
+
+    /* The other backend must round-trip too, and not verify under ours */
+    crypto_sign_keypair_sym(pk2, sk2, other);
+    crypto_sign_init(&sst, ctx, CTXLEN, sk2, other);
+    crypto_sign_update(&sst, m, MLEN);
+    crypto_sign_final(&sst, sig, &siglen);
+    crypto_sign_verify_init(&vst, ctx, CTXLEN, pk2, other);
+    crypto_sign_verify_update(&vst, m, MLEN);
+    if(crypto_sign_verify_final(&vst, sig, siglen)) {
+      fprintf(stderr, "%s signature does not verify\n", other->name);
+      return -1;
+    }
+    crypto_sign_public_key_init(&key, pk2, other, NULL);
+    if(crypto_sign_verify_key(sig, siglen, m, MLEN, ctx, CTXLEN, &key)) {
+      fprintf(stderr, "%s signature does not verify under a prepared key\n",
+              other->name);
+      return -1;
+    }
+    if(!crypto_sign_verify(sig, siglen, m, MLEN, ctx, CTXLEN, pk2)) {
+      fprintf(stderr, "%s signature verifies under %s\n", other->name,
+              dilithium_symmetric_default.name);
+      return -1;
+    }
     ret = crypto_sign_open(m2, &mlen, sm, smlen, ctx, CTXLEN, pk);
 
     if(ret) {
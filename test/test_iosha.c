@@ -0,0 +1,379 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../randombytes.h"
+#include "../iosha.h"
+#include "iosha_bytewise.h"
+
+#define NTESTS 1000
+#define MAXLEN 700
+
+/* iosha_permute of s[i] = 0x0101010101010101*i, from the scalar code */
+static const uint64_t permute_kat[16] = {
+  0x611AFACAC5E91DE1ULL, 0x2E83C07FC455C7FEULL,
+  0x5D94DA0D9D796BA6ULL, 0xFBFA40BC98EF60F3ULL,
+  0x8D214CE4101C6557ULL, 0xEB7D0EA4895C8D75ULL,
+  0x3E86738C5D0F5EB0ULL, 0xA96C5BCA4FB250BEULL,
+  0x0B70800246BB8903ULL, 0xA57CD86981434F24ULL,
+  0xC93AC7745A5DD7ABULL, 0xEB17AD476219E9C0ULL,
+  0xD59747CDFAFCDB86ULL, 0x53DD80BA0CBDCB22ULL,
+  0xC4452FFDE2355A01ULL, 0x263E75BFE324D9A3ULL
+};
+
+static int test_permute_kat(void)
+{
+  unsigned int i;
+  uint64_t s[16];
+
+  for(i = 0; i < 16; ++i)
+    s[i] = 0x0101010101010101ULL*i;
+  iosha_permute(s);
+
+  for(i = 0; i < 16; ++i)
+    if(s[i] != permute_kat[i]) {
+      fprintf(stderr, "iosha_permute differs from known answer\n");
+      return -1;
+    }
+
+  return 0;
+}
+
+static int test_absorb_words(void)
+{
+  unsigned int i, k;
+  size_t inlen, split;
+  uint8_t in[MAXLEN + 8];
+  uint16_t r[3];
+  iosha_ctx ctx, ref;
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes(in, sizeof(in));
+    randombytes((uint8_t *)r, sizeof(r));
+    inlen = r[0] % MAXLEN;
+    split = inlen ? r[1] % inlen : 0;
+    k = r[2] % 8;   /* misaligned input pointer */
+
+    iosha_init_128(&ctx, 0x01);
+    iosha_init_128(&ref, 0x01);
+    iosha_absorb(&ctx, in + k, split);
+    iosha_absorb(&ctx, in + k + split, inlen - split);
+    absorb_bytewise(&ref, in + k, inlen);
+
+    if(ctx.idx != ref.idx || memcmp(ctx.st, ref.st, sizeof(ctx.st))) {
+      fprintf(stderr, "iosha_absorb differs from bytewise absorb "
+              "(inlen %zu, split %zu)\n", inlen, split);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int test_permute_x4(void)
+{
+  unsigned int i, j, k;
+  uint64_t s[4][16];
+  uint64_t sx4[4*16];
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes((uint8_t *)s, sizeof(s));
+    for(j = 0; j < 16; ++j)
+      for(k = 0; k < 4; ++k)
+        sx4[4*j+k] = s[k][j];
+
+    for(k = 0; k < 4; ++k)
+      iosha_permute(s[k]);
+    iosha_permute_x4(sx4);
+
+    for(j = 0; j < 16; ++j)
+      for(k = 0; k < 4; ++k)
+        if(sx4[4*j+k] != s[k][j]) {
+          fprintf(stderr, "iosha_permute_x4 differs from iosha_permute\n");
+          return -1;
+        }
+  }
+
+  return 0;
+}
+
+static int test_sponge_x4(int rate128)
+{
+  unsigned int i, k;
+  size_t inlen, outlen;
+  uint8_t in[4][MAXLEN];
+  uint8_t out[4][MAXLEN];
+  uint8_t ref[MAXLEN];
+  uint16_t len[2];
+  iosha_ctx ctx;
+  iosha_ctx_x4 ctx4;
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes((uint8_t *)in, sizeof(in));
+    randombytes((uint8_t *)len, sizeof(len));
+    inlen = len[0] % MAXLEN;
+    outlen = len[1] % MAXLEN;
+
+    if(rate128)
+      iosha_init_128_x4(&ctx4, 0x01);
+    else
+      iosha_init_x4(&ctx4, 0x02);
+    /* Split the input to exercise partial blocks across calls */
+    iosha_absorb_x4(&ctx4, in[0], in[1], in[2], in[3], inlen/3);
+    iosha_absorb_x4(&ctx4, in[0] + inlen/3, in[1] + inlen/3,
+                    in[2] + inlen/3, in[3] + inlen/3, inlen - inlen/3);
+    iosha_squeeze_x4(&ctx4, out[0], out[1], out[2], out[3], outlen);
+
+    for(k = 0; k < 4; ++k) {
+      if(rate128)
+        iosha_init_128(&ctx, 0x01);
+      else
+        iosha_init(&ctx, 0x02);
+      iosha_absorb(&ctx, in[k], inlen);
+      iosha_squeeze(&ctx, ref, outlen);
+      if(memcmp(ref, out[k], outlen)) {
+        fprintf(stderr, "iosha_squeeze_x4 differs from iosha_squeeze "
+                "(rate %s, inlen %zu, outlen %zu)\n",
+                rate128 ? "96" : "64", inlen, outlen);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int test_permute_x8(void)
+{
+  unsigned int i, j, k;
+  uint64_t s[8][16];
+  uint64_t sx8[8*16];
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes((uint8_t *)s, sizeof(s));
+    for(j = 0; j < 16; ++j)
+      for(k = 0; k < 8; ++k)
+        sx8[8*j+k] = s[k][j];
+
+    for(k = 0; k < 8; ++k)
+      iosha_permute(s[k]);
+    iosha_permute_x8(sx8);
+
+    for(j = 0; j < 16; ++j)
+      for(k = 0; k < 8; ++k)
+        if(sx8[8*j+k] != s[k][j]) {
+          fprintf(stderr, "iosha_permute_x8 differs from iosha_permute\n");
+          return -1;
+        }
+  }
+
+  return 0;
+}
+
+static int test_sponge_x8(int rate128)
+{
+  unsigned int i, k;
+  size_t inlen, outlen;
+  uint8_t in[8][MAXLEN];
+  uint8_t out[8][MAXLEN];
+  uint8_t ref[MAXLEN];
+  uint16_t len[2];
+  iosha_ctx ctx;
+  iosha_ctx_x8 ctx8;
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes((uint8_t *)in, sizeof(in));
+    randombytes((uint8_t *)len, sizeof(len));
+    inlen = len[0] % MAXLEN;
+    outlen = len[1] % MAXLEN;
+
+    if(rate128)
+      iosha_init_128_x8(&ctx8, 0x01);
+    else
+      iosha_init_x8(&ctx8, 0x02);
+    iosha_absorb_x8(&ctx8, in[0], in[1], in[2], in[3],
+                    in[4], in[5], in[6], in[7], inlen);
+    iosha_squeeze_x8(&ctx8, out[0], out[1], out[2], out[3],
+                     out[4], out[5], out[6], out[7], outlen);
+
+    for(k = 0; k < 8; ++k) {
+      if(rate128)
+        iosha_init_128(&ctx, 0x01);
+      else
+        iosha_init(&ctx, 0x02);
+      iosha_absorb(&ctx, in[k], inlen);
+      iosha_squeeze(&ctx, ref, outlen);
+      if(memcmp(ref, out[k], outlen)) {
+        fprintf(stderr, "iosha_squeeze_x8 differs from iosha_squeeze "
+                "(rate %s, inlen %zu, outlen %zu)\n",
+                rate128 ? "96" : "64", inlen, outlen);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* Finalize-once squeezing: the x4/x8 streams must match the scalar one,
+   and the first block must equal the legacy re-padding squeeze output */
+static int test_squeezeblocks(int rate128)
+{
+  unsigned int i, k;
+  size_t inlen, nblocks, rate = rate128 ? 96 : 64;
+  uint8_t in[8][MAXLEN];
+  uint8_t out4[4][4*96];
+  uint8_t out8[8][4*96];
+  uint8_t ref[4*96];
+  uint8_t first[96];
+  uint16_t len[2];
+  iosha_ctx ctx;
+  iosha_ctx_x4 ctx4;
+  iosha_ctx_x8 ctx8;
+
+  for(i = 0; i < NTESTS; ++i) {
+    randombytes((uint8_t *)in, sizeof(in));
+    randombytes((uint8_t *)len, sizeof(len));
+    inlen = len[0] % MAXLEN;
+    nblocks = 1 + len[1] % 4;
+
+    if(rate128) {
+      iosha_init_128_x4(&ctx4, 0x01);
+      iosha_init_128_x8(&ctx8, 0x01);
+    } else {
+      iosha_init_x4(&ctx4, 0x01);
+      iosha_init_x8(&ctx8, 0x01);
+    }
+    iosha_absorb_x4(&ctx4, in[0], in[1], in[2], in[3], inlen);
+    iosha_finalize_x4(&ctx4);
+    iosha_squeezeblocks_x4(out4[0], out4[1], out4[2], out4[3], nblocks, &ctx4);
+    iosha_absorb_x8(&ctx8, in[0], in[1], in[2], in[3],
+                    in[4], in[5], in[6], in[7], inlen);
+    iosha_finalize_x8(&ctx8);
+    iosha_squeezeblocks_x8(out8[0], out8[1], out8[2], out8[3],
+                           out8[4], out8[5], out8[6], out8[7], nblocks, &ctx8);
+
+    for(k = 0; k < 8; ++k) {
+      if(rate128)
+        iosha_init_128(&ctx, 0x01);
+      else
+        iosha_init(&ctx, 0x01);
+      iosha_absorb(&ctx, in[k], inlen);
+      iosha_squeeze(&ctx, first, rate);
+
+      if(rate128)
+        iosha_init_128(&ctx, 0x01);
+      else
+        iosha_init(&ctx, 0x01);
+      iosha_absorb(&ctx, in[k], inlen);
+      iosha_finalize(&ctx);
+      iosha_squeezeblocks(ref, 1, &ctx);
+      iosha_squeezeblocks(ref + rate, nblocks - 1, &ctx);
+
+      if(memcmp(ref, first, rate)) {
+        fprintf(stderr, "first squeezed block differs from iosha_squeeze "
+                "(rate %zu, inlen %zu)\n", rate, inlen);
+        return -1;
+      }
+      if((k < 4 && memcmp(ref, out4[k], nblocks*rate))
+         || memcmp(ref, out8[k], nblocks*rate)) {
+        fprintf(stderr, "multi-buffer squeezeblocks differs from "
+                "iosha_squeezeblocks (rate %zu, inlen %zu)\n", rate, inlen);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* Sequential reference for the tree mode: one scalar sponge per leaf */
+static void tree_ref(const uint8_t *in, size_t inlen, uint8_t out[64])
+{
+  size_t i, len, off = 0;
+  uint8_t b[8], cv[64];
+  iosha_ctx leaf, root;
+
+  iosha_init(&root, 0x04);
+  do {
+    len = inlen - off < IOSHA_TREE_LEAFBYTES ? inlen - off : IOSHA_TREE_LEAFBYTES;
+    for(i = 0; i < 8; ++i)
+      b[i] = (uint8_t)((uint64_t)(off/IOSHA_TREE_LEAFBYTES) >> 8*i);
+    iosha_init(&leaf, 0x03);
+    iosha_absorb(&leaf, b, 8);
+    iosha_absorb(&leaf, in + off, len);
+    iosha_squeeze(&leaf, cv, 64);
+    iosha_absorb(&root, cv, 64);
+    off += len;
+  } while(off < inlen);
+
+  for(i = 0; i < 8; ++i)
+    b[i] = (uint8_t)((uint64_t)inlen >> 8*i);
+  iosha_absorb(&root, b, 8);
+  iosha_squeeze(&root, out, 64);
+}
+
+static int test_tree(void)
+{
+  static uint8_t in[300*IOSHA_TREE_LEAFBYTES + 5];
+  const size_t lens[] = { 0, 1, IOSHA_TREE_LEAFBYTES - 1, IOSHA_TREE_LEAFBYTES,
+                          3*IOSHA_TREE_LEAFBYTES + 1, 4*IOSHA_TREE_LEAFBYTES,
+                          9*IOSHA_TREE_LEAFBYTES + 17, sizeof(in) };
+  unsigned int i;
+  size_t off, n;
+  uint32_t r;
+  uint8_t out[64], ref[64];
+  iosha_tree_ctx ctx;
+
+  randombytes(in, sizeof(in));
+  for(i = 0; i < sizeof(lens)/sizeof(lens[0]); ++i) {
+    iosha_tree_bytes(in, lens[i], out, 64);
+    tree_ref(in, lens[i], ref);
+    if(memcmp(out, ref, 64)) {
+      fprintf(stderr, "iosha_tree_bytes differs from sequential tree "
+              "(inlen %zu)\n", lens[i]);
+      return -1;
+    }
+
+    /* Random chunks, some long enough for the x4 path */
+    iosha_tree_init(&ctx);
+    for(off = 0; off < lens[i]; off += n) {
+      randombytes((uint8_t *)&r, sizeof(r));
+      n = r % (6*IOSHA_TREE_LEAFBYTES);
+      if(n > lens[i] - off)
+        n = lens[i] - off;
+      iosha_tree_update(&ctx, in + off, n);
+    }
+    iosha_tree_final(&ctx, out, 64);
+    if(memcmp(out, ref, 64)) {
+      fprintf(stderr, "iosha_tree_update differs from iosha_tree_bytes "
+              "(inlen %zu)\n", lens[i]);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  if(test_permute_kat())
+    return -1;
+  if(test_absorb_words())
+    return -1;
+  if(test_permute_x4())
+    return -1;
+  if(test_sponge_x4(0) || test_sponge_x4(1))
+    return -1;
+  if(test_permute_x8())
+    return -1;
+  if(test_sponge_x8(0) || test_sponge_x8(1))
+    return -1;
+  if(test_squeezeblocks(0) || test_squeezeblocks(1))
+    return -1;
+  if(test_tree())
+    return -1;
+
+  printf("IOSHA tests passed\n");
+  return 0;
+}
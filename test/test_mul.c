@@ -29,8 +29,8 @@ int main(void) {
 
   randombytes(seed, sizeof(seed));
   for(i = 0; i < NTESTS; ++i) {
-    poly_uniform(&a, seed, nonce++);
-    poly_uniform(&b, seed, nonce++);
+    poly_uniform(&a, seed, nonce++, &dilithium_symmetric_default);
+    poly_uniform(&b, seed, nonce++, &dilithium_symmetric_default);
 
     c = a;
     poly_ntt(&c);
@@ -1,8 +1,12 @@
 #include <stdint.h>
+#include <stdio.h>
 #include "../sign.h"
 #include "../poly.h"
 #include "../polyvec.h"
+#include "../rejsample.h"
 #include "../params.h"
+#include "../iosha.h"
+#include "../randombytes.h"
 #include "cpucycles.h"
 #include "speed_print.h"
 
@@ -10,6 +14,151 @@
 
 uint64_t t[NTESTS];
 
+static matcache_entry cache_mem[1];
+
+/* The same pipeline on one hash backend, through the context API. Keys
+   and rnd come from a fixed-seed deterministic source, so every run (and
+   every backend) replays the same randomness. */
+static void bench_backend(const dilithium_symmetric *sym)
+{
+  unsigned int i;
+  size_t siglen;
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t seed[CRHBYTES] = {0};
+  char name[64];
+  polyvecl mat[K];
+  dilithium_signing_key ssk;
+  dilithium_verify_ctx vst;
+  randombytes_rng rng;
+  randombytes_det_state det;
+
+  randombytes_det_init(&rng, &det, seed, sizeof(seed));
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    polyvec_matrix_expand(mat, seed, sym);
+  }
+  snprintf(name, sizeof(name), "polyvec_matrix_expand (%s):", sym->name);
+  print_results(name, t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    polyvecl_uniform_gamma1(&mat[0], seed, 0, sym);
+  }
+  snprintf(name, sizeof(name), "polyvecl_uniform_gamma1 (%s):", sym->name);
+  print_results(name, t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_keypair_rng(pk, sk, sym, &rng);
+  }
+  snprintf(name, sizeof(name), "Keypair (%s):", sym->name);
+  print_results(name, t, NTESTS);
+
+  crypto_sign_signing_key_init(&ssk, sk, sym, &rng);
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_signature_key(sig, &siglen, sig, CRHBYTES, NULL, 0, &ssk);
+  }
+  snprintf(name, sizeof(name), "Sign (%s):", sym->name);
+  print_results(name, t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify_init(&vst, NULL, 0, pk, sym);
+    crypto_sign_verify_update(&vst, sig, CRHBYTES);
+    crypto_sign_verify_final(&vst, sig, CRYPTO_BYTES);
+  }
+  snprintf(name, sizeof(name), "Verify (%s):", sym->name);
+  print_results(name, t, NTESTS);
+}
+
+/* Throughput of a rejection sampler over the five SHAKE128 blocks that
+   poly_uniform starts from */
+static void bench_rej(const char *s,
+                      unsigned int (*rej)(int32_t *, unsigned int,
+                                          const uint8_t *, unsigned int))
+{
+  unsigned int i;
+  uint64_t cycles, coeffs;
+  uint8_t buf[5*168];
+  int32_t a[2*5*168];
+
+  randombytes(buf, sizeof(buf));
+  cycles = coeffs = 0;
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    coeffs += rej(a, sizeof(a)/sizeof(a[0]), buf, sizeof(buf));
+    cycles += cpucycles() - t[i];
+  }
+  print_results(s, t, NTESTS);
+  printf("%s %.2f coefficients/cycle\n\n", s, (double)coeffs/cycles);
+}
+
+/* The per-iteration challenge products of signing, c*s1, c*s2 and c*t0,
+   through the NTT and with the sparse kernels; then NTT(c) for verify,
+   dense and from the column table */
+static void bench_challenge_mul(const poly *cp)
+{
+  unsigned int i;
+  poly chat;
+  poly_sparse c;
+  polyvecl s1, z;
+  polyveck s2, t0, h;
+
+  polyvecl_uniform_eta(&s1, (const uint8_t *)cp, 0, &dilithium_symmetric_default);
+  polyveck_uniform_eta(&s2, (const uint8_t *)cp, L, &dilithium_symmetric_default);
+  polyveck_uniform_eta(&t0, (const uint8_t *)cp, L + K, &dilithium_symmetric_default);
+  z = s1;
+  h = s2;
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    chat = *cp;
+    poly_ntt(&chat);
+    polyvecl_pointwise_poly_montgomery(&z, &chat, &s1);
+    polyvecl_invntt_tomont(&z);
+    polyveck_pointwise_poly_montgomery(&h, &chat, &s2);
+    polyveck_invntt_tomont(&h);
+    polyveck_pointwise_poly_montgomery(&h, &chat, &t0);
+    polyveck_invntt_tomont(&h);
+  }
+  print_results("c*s1, c*s2, c*t0 (NTT):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_sparse_from_challenge(&c, cp);
+    polyvecl_sparse_mul_add(&z, &c, &s1);
+    polyveck_sparse_mul_sub(&h, &c, &s2);
+    polyveck_sparse_mul(&h, &c, &t0);
+  }
+  print_results("c*s1, c*s2, c*t0 (sparse):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    chat = *cp;
+    poly_ntt(&chat);
+  }
+  print_results("NTT(c) (dense):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_sparse_from_challenge(&c, cp);
+    poly_sparse_ntt(&chat, &c);
+  }
+  printf("SPARSE_NTT_COLUMNS = %d\n", SPARSE_NTT_COLUMNS);
+  print_results("NTT(c) (sparse):", t, NTESTS);
+}
+
+#ifdef IOSHA_STATS
+static void print_permutations(const char *s, unsigned long long start) {
+  printf("%s %.1f IOSHA permutations/op\n\n", s,
+         (double)(iosha_permute_count - start)/NTESTS);
+}
+#endif
+
 int main(void)
 {
   unsigned int i;
@@ -19,25 +168,37 @@ int main(void)
   uint8_t sig[CRYPTO_BYTES];
   uint8_t seed[CRHBYTES];
   polyvecl mat[K];
+  dilithium_signing_key ssk;
+  dilithium_sign_ctx sst;
+  dilithium_matrix_cache cache;
+  dilithium_public_key key;
   poly *a = &mat[0].vec[0];
   poly *b = &mat[0].vec[1];
   poly *c = &mat[0].vec[2];
+#ifdef IOSHA_STATS
+  unsigned long long perms;
+#endif
 
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
-    polyvec_matrix_expand(mat, seed);
+    polyvec_matrix_expand(mat, seed, &dilithium_symmetric_default);
   }
   print_results("polyvec_matrix_expand:", t, NTESTS);
 
+  bench_rej("rej_uniform_ref:", rej_uniform_ref);
+  bench_rej("rej_uniform:", rej_uniform);
+  bench_rej("rej_eta_ref:", rej_eta_ref);
+  bench_rej("rej_eta:", rej_eta);
+
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
-    poly_uniform_eta(a, seed, 0);
+    poly_uniform_eta(a, seed, 0, &dilithium_symmetric_default);
   }
   print_results("poly_uniform_eta:", t, NTESTS);
 
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
-    poly_uniform_gamma1(a, seed, 0);
+    poly_uniform_gamma1(a, seed, 0, &dilithium_symmetric_default);
   }
   print_results("poly_uniform_gamma1:", t, NTESTS);
 
@@ -61,27 +222,87 @@ int main(void)
 
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
-    poly_challenge(c, seed);
+    poly_challenge(c, seed, &dilithium_symmetric_default);
   }
   print_results("poly_challenge:", t, NTESTS);
 
+  bench_challenge_mul(c);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    randombytes(seed, RNDBYTES);
+  }
+  print_results("randombytes:", t, NTESTS);
+
+#ifdef IOSHA_STATS
+  perms = iosha_permute_count;
+#endif
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
     crypto_sign_keypair(pk, sk);
   }
   print_results("Keypair:", t, NTESTS);
+#ifdef IOSHA_STATS
+  print_permutations("Keypair:", perms);
+#endif
 
+#ifdef IOSHA_STATS
+  perms = iosha_permute_count;
+#endif
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
     crypto_sign_signature(sig, &siglen, sig, CRHBYTES, NULL, 0, sk);
   }
   print_results("Sign:", t, NTESTS);
+#ifdef IOSHA_STATS
+  print_permutations("Sign:", perms);
+#endif
 
+  crypto_sign_signing_key_init(&ssk, sk, NULL, NULL);
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_signature_key(sig, &siglen, sig, CRHBYTES, NULL, 0, &ssk);
+  }
+  print_results("Sign (prepared key):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_init(&sst, NULL, 0, sk, NULL);
+    crypto_sign_update(&sst, sig, CRHBYTES);
+    crypto_sign_final(&sst, sig, &siglen);
+  }
+  print_results("Sign (streaming):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_init_key(&sst, NULL, 0, &ssk);
+    crypto_sign_update(&sst, sig, CRHBYTES);
+    crypto_sign_final(&sst, sig, &siglen);
+  }
+  print_results("Sign (streaming, prepared key):", t, NTESTS);
+
+#ifdef IOSHA_STATS
+  perms = iosha_permute_count;
+#endif
   for(i = 0; i < NTESTS; ++i) {
     t[i] = cpucycles();
     crypto_sign_verify(sig, CRYPTO_BYTES, sig, CRHBYTES, NULL, 0, pk);
   }
   print_results("Verify:", t, NTESTS);
+#ifdef IOSHA_STATS
+  print_permutations("Verify:", perms);
+#endif
+
+  matrix_cache_init(&cache, cache_mem, sizeof(cache_mem));
+  crypto_sign_public_key_init(&key, pk, NULL, &cache);
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify_key(sig, CRYPTO_BYTES, sig, CRHBYTES, NULL, 0, &key);
+  }
+  print_results("Verify (prepared key, cached A):", t, NTESTS);
+
+  bench_backend(&dilithium_symmetric_iosha);
+  bench_backend(&dilithium_symmetric_shake);
 
   return 0;
 }
@@ -75,7 +75,7 @@ int main(void) {
       printf("%02X", seed[j]);
     printf("\n");
 
-    polyvec_matrix_expand(mat, seed);
+    polyvec_matrix_expand(mat, seed, &dilithium_symmetric_default);
     printf("A = ([");
     for(j = 0; j < K; ++j) {
       for(k = 0; k < L; ++k) {
@@ -89,7 +89,7 @@ int main(void) {
       }
     }
 
-    polyvecl_uniform_eta(&s, seed, 0);
+    polyvecl_uniform_eta(&s, seed, 0, &dilithium_symmetric_default);
 
     polyeta_pack(buf, &s.vec[0]);
     polyeta_unpack(&tmp, buf);
@@ -110,7 +110,7 @@ int main(void) {
       }
     }
 
-    polyvecl_uniform_gamma1(&y, seed, 0);
+    polyvecl_uniform_gamma1(&y, seed, 0, &dilithium_symmetric_default);
 
     polyz_pack(buf, &y.vec[0]);
     polyz_unpack(&tmp, buf);
@@ -230,7 +230,7 @@ int main(void) {
       }
     }
 
-    poly_challenge(&c, seed);
+    poly_challenge(&c, seed, &dilithium_symmetric_default);
     printf("c = [");
     for(j = 0; j < N; ++j) {
       printf("%2d", c.coeffs[j]);